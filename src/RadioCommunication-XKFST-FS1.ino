@@ -3,15 +3,46 @@
 #include "states/StateIds.h"
 #include "states/idle/IdleState.h"
 #include "states/sync/SyncState.h"
+#include "states/tx/TxState.h"
+#include "capture/EdgeCapture.h"
+#include "power/PowerManager.h"
 
 // --- Pin Configuration ---
 const int RX_PIN = 4;       // Pin for the RF receiver module
 const int TX_PIN = 5;       // Pin for the RF transmitter module
 const int BUTTON_PIN = 3;   // Pin for the manual trigger button
 
+// --- Edge Capture Configuration ---
+// Where recorded sync sessions go. Serial mixes binary captures into the log output;
+// Flash requires an "edgecap" data partition in the partition table.
+const EdgeCaptureSink CAPTURE_SINK = EdgeCaptureSink::None;
+
+// --- Power Configuration ---
+// When true, IdleState puts the CPU into light sleep until RX_PIN, BUTTON_PIN or a
+// scheduled timer wakes it. Serial input (capture replay) is not serviced while asleep.
+const bool LOW_POWER_IDLE = false;
+
+// Light sleep primitives and the power manager built on them.
+EspSleepHal espSleepHal;
+PowerManager powerManager(espSleepHal);
+
 // A global pointer to the state machine instance.
 StateMachine<MasterStates>* stateMachine;
 
+#ifdef STATE_PROFILING
+// Deadline/WCET statistics of the master states. Enabled with -DSTATE_PROFILING.
+StateProfiler<MasterStates> masterProfiler;
+
+/**
+ * @brief Reports a master state whose handle() call exceeded its budget.
+ * Runs from update(), not from an ISR.
+ */
+void onMasterOverrun(MasterStates id, uint32_t elapsedUs, uint32_t budgetUs) {
+    Serial.printf("Deadline overrun: master state %d took %lu us (budget %lu us)\n",
+                  static_cast<int>(id), (unsigned long)elapsedUs, (unsigned long)budgetUs);
+}
+#endif
+
 
 /**
  * @brief Interrupt Service Routine (ISR) for the radio signal.
@@ -49,17 +80,30 @@ void setup() {
     digitalWrite(TX_PIN, LOW);
     pinMode(BUTTON_PIN, INPUT_PULLUP); // Configure button pin with internal pull-up
 
+    edgeCapture.begin(CAPTURE_SINK, RX_PIN);
+
     // Dynamically allocate and instantiate the state machine with its states.
     stateMachine = new StateMachine<MasterStates>(
         MasterStates::Idle,         // The initial state of the machine.
         IdleState<MasterStates>(),  // An instance of the Idle state.
-        SyncState<MasterStates>()   // An instance of the Sync state.
+        SyncState<MasterStates>(),  // An instance of the Sync state.
+        TxState<MasterStates>()     // An instance of the Tx state, fed by txScheduler.
     );
 
+#ifdef STATE_PROFILING
+    masterProfiler.setOverrunCallback(onMasterOverrun);
+    stateMachine->setProfiler(&masterProfiler);
+#endif
+
     // Attach interrupts
     attachInterrupt(digitalPinToInterrupt(RX_PIN), handleRadioPulse, CHANGE);
     attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), handleButtonPress, FALLING);
 
+    if (LOW_POWER_IDLE) {
+        espSleepHal.begin(RX_PIN, handleRadioPulse, BUTTON_PIN, handleButtonPress);
+        powerManager.begin();
+    }
+
     Serial.println("State Machine created. Waiting for events via interrupts...");
 }
 
@@ -68,6 +112,38 @@ void loop() {
     // This calls the handle() method of the current state.
     stateMachine->update();
 
+    // Host commands (see tools/edgecap.py), only accepted while Idle:
+    // a capture file, recognised by its magic, is replayed through the sync decoder;
+    // the text commands "dump" and "erase" read out and clear the stored flash captures.
+    if (Serial.available() && stateMachine->getCurrentStateId() == MasterStates::Idle) {
+        if (Serial.peek() == EDGE_CAPTURE_MAGIC[0]) {
+            if (edgeCapture.loadReplay(Serial)) {
+                stateMachine->setState(MasterStates::Sync, SyncStates::Replay);
+            }
+        } else {
+            String command = Serial.readStringUntil('\n');
+            command.trim();
+            if (command == "dump") {
+                edgeCapture.dumpStored(Serial);
+            } else if (command == "erase") {
+                edgeCapture.eraseStored();
+            }
+        }
+    }
+
+#ifdef STATE_PROFILING
+    // Dump the WCET histograms once per finished sync session.
+    static MasterStates lastStateId = MasterStates::Idle;
+    MasterStates stateId = stateMachine->getCurrentStateId();
+    if (lastStateId == MasterStates::Sync && stateId == MasterStates::Idle) {
+        Serial.println("WCET master:");
+        masterProfiler.dump(Serial);
+        Serial.println("WCET sync:");
+        syncProfiler.dump(Serial);
+    }
+    lastStateId = stateId;
+#endif
+
     // The loop only needs to call update(). State transitions are
     // initiated by events (interrupts).
 }
@@ -0,0 +1,312 @@
+#include "EdgeCapture.h"
+#include <Arduino.h>
+#include "esp_partition.h"
+
+// Label of the data partition used by EdgeCaptureSink::Flash.
+static const char* CAPTURE_PARTITION_LABEL = "edgecap";
+
+// Flash erase granularity.
+static const size_t FLASH_SECTOR_SIZE = 4096;
+
+EdgeCapture edgeCapture;
+
+EdgeCapture::EdgeCapture()
+    : encoder_(buffer_, BUFFER_SIZE), replayer_(buffer_, 0) {}
+
+void EdgeCapture::begin(EdgeCaptureSink sink, int rxPin) {
+    sink_ = sink;
+    rxPin_ = rxPin;
+    if (sink_ != EdgeCaptureSink::Flash) {
+        return;
+    }
+
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CAPTURE_PARTITION_LABEL);
+    if (!partition_) {
+        Serial.println("EdgeCapture: 'edgecap' partition not found, recording disabled.");
+        sink_ = EdgeCaptureSink::None;
+        return;
+    }
+
+    // Captures survive resets: walk the stored headers to find where to append.
+    partitionOffset_ = 0;
+    storedCaptures_ = 0;
+    storedBytes_ = 0;
+    uint32_t payloadLength = 0;
+    while (findStoredCapture(partitionOffset_, payloadLength)) {
+        partitionOffset_ += EDGE_CAPTURE_HEADER_SIZE + payloadLength;
+        storedCaptures_++;
+        storedBytes_ += EDGE_CAPTURE_HEADER_SIZE + payloadLength;
+    }
+    if (storedCaptures_ == 0 && partitionOffset_ != 0) {
+        // Nothing but foreign data: the partition was never erased for us.
+        esp_partition_erase_range(partition_, 0, partition_->size);
+        partitionOffset_ = 0;
+    }
+    Serial.printf("EdgeCapture: %lu stored captures, %u bytes used.\n",
+                  (unsigned long)storedCaptures_, (unsigned)partitionOffset_);
+}
+
+// Scans forward from offset for the next stored capture.
+// Flash is written strictly in order, so the first erased header slot is the
+// end of the data. Anything else that is not a valid header is the remains of
+// a write cut short by a reset; the rest of that sector is abandoned and the
+// scan resumes at the next sector boundary, where flush() continued writing.
+// On false, offset is the position where the next capture goes.
+bool EdgeCapture::findStoredCapture(size_t& offset, uint32_t& payloadLength) {
+    uint8_t header[EDGE_CAPTURE_HEADER_SIZE];
+    while (offset + sizeof(header) <= partition_->size) {
+        esp_partition_read(partition_, offset, header, sizeof(header));
+        if (parseEdgeCaptureHeader(header, payloadLength) &&
+            offset + sizeof(header) + payloadLength <= partition_->size) {
+            return true;
+        }
+
+        bool erased = true;
+        for (size_t i = 0; erased && i < sizeof(header); ++i) {
+            erased = header[i] == 0xFF;
+        }
+        if (erased) {
+            return false;
+        }
+        offset = (offset / FLASH_SECTOR_SIZE + 1) * FLASH_SECTOR_SIZE;
+    }
+    offset = partition_->size;
+    return false;
+}
+
+// Makes [offset, offset + length) writable. Nothing valid is stored at or after
+// the append point, so any sector there that is not erased (a torn write, or a
+// partition that was never erased) can be wiped. The sector holding offset may
+// also hold earlier captures; if its tail is dirty, the write skips to the next
+// sector instead and leaves a gap that findStoredCapture() steps over.
+bool EdgeCapture::prepareFlashRange(size_t& offset, size_t length) {
+    uint8_t probe[64];
+    bool erased = true;
+    for (size_t at = offset; erased && at < offset + length; at += sizeof(probe)) {
+        size_t chunk = offset + length - at < sizeof(probe) ? offset + length - at : sizeof(probe);
+        esp_partition_read(partition_, at, probe, chunk);
+        for (size_t i = 0; erased && i < chunk; ++i) {
+            erased = probe[i] == 0xFF;
+        }
+    }
+    if (erased) {
+        return true;
+    }
+
+    if (offset % FLASH_SECTOR_SIZE) {
+        // Mark the abandoned slot so a later scan does not take it for the end of
+        // the data: programming a byte to 0 is always possible without an erase.
+        const uint8_t skipMarker = 0;
+        esp_partition_write(partition_, offset, &skipMarker, 1);
+        offset = (offset / FLASH_SECTOR_SIZE + 1) * FLASH_SECTOR_SIZE;
+    }
+    size_t eraseEnd = (offset + length + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+    if (eraseEnd > partition_->size) {
+        return false;
+    }
+    esp_partition_erase_range(partition_, offset, eraseEnd - offset);
+    return true;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void IRAM_ATTR EdgeCapture::onRxEdge() {
+    edgeCapture.pushEdge();
+}
+
+// Runs in interrupt context: timestamp only, encoding happens in poll().
+void IRAM_ATTR EdgeCapture::pushEdge() {
+    uint32_t entry = (static_cast<uint32_t>(micros()) & ~1u) | (digitalRead(rxPin_) == HIGH ? 1 : 0);
+    uint16_t next = (ringHead_ + 1) % EDGE_RING_SIZE;
+    if (next == ringTail_) {
+        ringOverflowed_ = true;
+        return;
+    }
+    edgeRing_[ringHead_] = entry;
+    ringHead_ = next;
+}
+
+void EdgeCapture::beginSession() {
+    if (replaying_) {
+        replayer_.rewind();
+        wakePulsePending_ = replayFlags_ & EDGE_CAPTURE_FLAG_WAKE_START;
+        return;
+    }
+    wakeStart_ = false;
+    recording_ = sink_ != EdgeCaptureSink::None;
+    if (!recording_) {
+        return;
+    }
+
+    encoder_.reset();
+    keep_ = false;
+    ringHead_ = ringTail_ = 0;
+    ringOverflowed_ = false;
+    lineLevel_ = digitalRead(rxPin_) == HIGH ? 1 : 0;
+    lastEdgeUs_ = static_cast<uint32_t>(micros()) & ~1u;
+    attachInterrupt(digitalPinToInterrupt(rxPin_), onRxEdge, CHANGE);
+}
+
+void EdgeCapture::markWakeEdge(unsigned long risingEdgeUs) {
+    uint32_t edgeUs = static_cast<uint32_t>(risingEdgeUs) & ~1u;
+    // Only a session that starts inside the pulse, before any edge was drained, can be backdated.
+    if (!recording_ || lineLevel_ != 1 || encoder_.records() ||
+        static_cast<int32_t>(lastEdgeUs_ - edgeUs) < 0) {
+        return;
+    }
+    lastEdgeUs_ = edgeUs;
+    wakeStart_ = true;
+}
+
+void EdgeCapture::poll() {
+    if (!recording_) {
+        return;
+    }
+    while (ringTail_ != ringHead_) {
+        uint32_t entry = edgeRing_[ringTail_];
+        ringTail_ = (ringTail_ + 1) % EDGE_RING_SIZE;
+
+        uint32_t edgeUs = entry & ~1u;
+        // The line held lineLevel_ from the previous edge up to this one.
+        // A missed edge shows up as two segments of the same level, which replay merges.
+        encoder_.push(lineLevel_, edgeUs - lastEdgeUs_);
+        lineLevel_ = entry & 1;
+        lastEdgeUs_ = edgeUs;
+    }
+}
+
+void EdgeCapture::keepSession() {
+    keep_ = true;
+}
+
+void EdgeCapture::endSession() {
+    if (replaying_) {
+        replaying_ = false;
+        return;
+    }
+    if (!recording_) {
+        return;
+    }
+
+    detachInterrupt(digitalPinToInterrupt(rxPin_));
+    recording_ = false;
+    poll();
+    // Close the timeline with the level held since the last edge.
+    encoder_.push(lineLevel_, (static_cast<uint32_t>(micros()) & ~1u) - lastEdgeUs_);
+
+    if (keep_) {
+        flush();
+    }
+}
+
+void EdgeCapture::flush() {
+    uint8_t flags = 0;
+    if (encoder_.overflowed()) flags |= EDGE_CAPTURE_FLAG_TRUNCATED;
+    if (ringOverflowed_) flags |= EDGE_CAPTURE_FLAG_EDGES_DROPPED;
+    if (wakeStart_) flags |= EDGE_CAPTURE_FLAG_WAKE_START;
+    uint8_t header[EDGE_CAPTURE_HEADER_SIZE];
+    writeEdgeCaptureHeader(header, encoder_.size(), flags);
+
+    if (sink_ == EdgeCaptureSink::SerialPort) {
+        Serial.write(header, sizeof(header));
+        Serial.write(encoder_.data(), encoder_.size());
+        Serial.println();
+    } else if (sink_ == EdgeCaptureSink::Flash) {
+        size_t total = sizeof(header) + encoder_.size();
+        size_t offset = partitionOffset_;
+        if (offset + total > partition_->size || !prepareFlashRange(offset, total)) {
+            Serial.println("EdgeCapture: Partition full, capture dropped. Dump and erase to free it.");
+            return;
+        }
+        esp_partition_write(partition_, offset, header, sizeof(header));
+        esp_partition_write(partition_, offset + sizeof(header), encoder_.data(), encoder_.size());
+        partitionOffset_ = offset + total;
+        storedCaptures_++;
+        storedBytes_ += total;
+    }
+
+    if (flags & EDGE_CAPTURE_FLAG_TRUNCATED) {
+        Serial.println("EdgeCapture: Buffer overflowed, capture truncated.");
+    }
+    if (flags & EDGE_CAPTURE_FLAG_EDGES_DROPPED) {
+        Serial.println("EdgeCapture: Edge ring overflowed, edges dropped; capture flagged.");
+    }
+}
+
+// ============================================================================
+// Flash sink maintenance
+// ============================================================================
+
+void EdgeCapture::dumpStored(Print& out) {
+    out.printf("EDGECAP DUMP %lu %u\n", (unsigned long)storedCaptures_, (unsigned)storedBytes_);
+    if (!partition_) {
+        return;
+    }
+
+    // Only the captures themselves are sent, not the gaps left by torn writes.
+    // They stream through the RAM buffer; no recording is active while Idle.
+    size_t offset = 0;
+    uint32_t payloadLength = 0;
+    while (offset < partitionOffset_ && findStoredCapture(offset, payloadLength)) {
+        size_t end = offset + EDGE_CAPTURE_HEADER_SIZE + payloadLength;
+        for (; offset < end; offset += BUFFER_SIZE) {
+            size_t chunk = end - offset < BUFFER_SIZE ? end - offset : BUFFER_SIZE;
+            esp_partition_read(partition_, offset, buffer_, chunk);
+            out.write(buffer_, chunk);
+        }
+        offset = end;
+    }
+}
+
+void EdgeCapture::eraseStored() {
+    if (!partition_) {
+        return;
+    }
+    esp_partition_erase_range(partition_, 0, partition_->size);
+    partitionOffset_ = 0;
+    storedCaptures_ = 0;
+    storedBytes_ = 0;
+    Serial.println("EdgeCapture: Stored captures erased.");
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+bool EdgeCapture::loadReplay(Stream& in) {
+    uint8_t header[EDGE_CAPTURE_HEADER_SIZE];
+    uint32_t payloadLength = 0;
+    if (in.readBytes(header, sizeof(header)) != sizeof(header) || !parseEdgeCaptureHeader(header, payloadLength, &replayFlags_)) {
+        Serial.println("EdgeCapture: Invalid capture header.");
+        while (in.available()) in.read(); // Drop the rest of the garbage.
+        return false;
+    }
+    if (payloadLength > BUFFER_SIZE) {
+        Serial.println("EdgeCapture: Capture too large for replay buffer.");
+        while (in.available()) in.read();
+        return false;
+    }
+    if (in.readBytes(buffer_, payloadLength) != payloadLength) {
+        Serial.println("EdgeCapture: Capture truncated.");
+        return false;
+    }
+
+    replayer_ = EdgeReplayer(buffer_, payloadLength);
+    replaying_ = true;
+    return true;
+}
+
+unsigned long EdgeCapture::replayPulse(uint8_t level, unsigned long timeoutUs) {
+    return replayer_.pulseIn(level == HIGH ? 1 : 0, timeoutUs);
+}
+
+bool EdgeCapture::replayWakePulse(unsigned long maxUs, unsigned long& durationUs) {
+    if (!replaying_ || !wakePulsePending_) {
+        return false;
+    }
+    wakePulsePending_ = false;
+    durationUs = replayer_.ongoingPulse(1, maxUs);
+    return durationUs != 0;
+}
@@ -0,0 +1,159 @@
+// FILE: src/capture/EdgeCapture.h
+
+#ifndef EDGECAPTURE_H
+#define EDGECAPTURE_H
+
+#include "EdgeCodec.h"
+#include <Arduino.h>
+#include "esp_partition.h"
+
+/**
+ * @brief Where finished capture sessions are written.
+ */
+enum class EdgeCaptureSink {
+    None,       // Recording disabled.
+    SerialPort, // Binary capture file written to the serial port.
+    Flash       // Appended to the "edgecap" data partition.
+};
+
+/**
+ * @class EdgeCapture
+ * @brief Records the RX line during sync sessions and replays recorded
+ * captures back into the sync sub-states.
+ *
+ * A session spans one run of the sync sub-machine. While recording, an edge
+ * ISR on the RX pin timestamps every level change into a ring; the main loop
+ * drains it into (level, duration) records, so the capture is the complete
+ * line timeline rather than whatever the decoder happened to measure. Only
+ * sessions marked with keepSession() are written to the sink.
+ *
+ * While replaying, the same buffer holds a capture loaded from the host and
+ * replayPulse() answers pulseIn() calls from the timeline via EdgeReplayer,
+ * without waiting on the radio.
+ */
+class EdgeCapture {
+public:
+    // Payload buffer size. A noisy 500 ms handshake wait is the worst case.
+    static const size_t BUFFER_SIZE = 8192;
+
+    // Edge timestamps buffered between two drains.
+    static const size_t EDGE_RING_SIZE = 512;
+
+    EdgeCapture();
+
+    /**
+     * @brief Selects the sink and the RX pin to record.
+     * For Flash, finds the end of the captures already stored in the partition.
+     * Never erases: stored captures survive resets, including torn writes.
+     */
+    void begin(EdgeCaptureSink sink, int rxPin);
+
+    /**
+     * @brief Starts a new session. Attaches the edge ISR unless a replay is armed.
+     * Call with the RX pin's own ISR detached.
+     */
+    void beginSession();
+
+    /**
+     * @brief Backdates the start of a session that began on a light-sleep radio
+     * wake to the estimated rising edge of the waking pulse, and flags the
+     * capture so replay times that pulse like PowerManager::measureWakePulse().
+     * Call right after beginSession(), while the line is still HIGH.
+     */
+    void markWakeEdge(unsigned long risingEdgeUs);
+
+    /**
+     * @brief Moves buffered edges from the ISR ring into the capture. Call often.
+     */
+    void poll();
+
+    /**
+     * @brief Marks the current session as worth storing.
+     * Sessions that never get this far (noise wake-ups) are discarded.
+     */
+    void keepSession();
+
+    /**
+     * @brief Ends the session: detaches the edge ISR and writes a kept recording
+     * to the sink, or disarms the replay.
+     */
+    void endSession();
+
+    /**
+     * @brief Reads one capture file from a stream and arms it for replay.
+     * @return true if a valid capture was loaded.
+     */
+    bool loadReplay(Stream& in);
+
+    bool isReplaying() const { return replaying_; }
+
+    /**
+     * @brief Drop-in replacement for pulseIn() backed by the loaded capture.
+     * @return The pulse duration, or 0 on timeout or end of capture.
+     */
+    unsigned long replayPulse(uint8_t level, unsigned long timeoutUs);
+
+    /**
+     * @brief Replay counterpart of PowerManager::measureWakePulse() for captures
+     * flagged EDGE_CAPTURE_FLAG_WAKE_START. Only valid once per session.
+     * @return false if the capture did not start on a wake or the pulse is not there.
+     */
+    bool replayWakePulse(unsigned long maxUs, unsigned long& durationUs);
+
+    uint32_t getReplayedEdges() const { return replayer_.getEdges(); }
+    bool isReplayMalformed() const { return replayer_.malformed(); }
+    // EDGE_CAPTURE_FLAG_* bits of the loaded capture. Flagged captures may not replay as they ran live.
+    uint8_t getReplayFlags() const { return replayFlags_; }
+
+    // --- Flash sink maintenance ---
+
+    /**
+     * @brief Writes "EDGECAP DUMP <count> <bytes>" and then all stored captures
+     * back to back, each with its own header.
+     */
+    void dumpStored(Print& out);
+
+    /**
+     * @brief Erases all stored captures.
+     */
+    void eraseStored();
+
+private:
+    static void IRAM_ATTR onRxEdge();
+    void IRAM_ATTR pushEdge();
+    void flush();
+    bool findStoredCapture(size_t& offset, uint32_t& payloadLength);
+    bool prepareFlashRange(size_t& offset, size_t length);
+
+    EdgeCaptureSink sink_ = EdgeCaptureSink::None;
+    int rxPin_ = -1;
+    uint8_t buffer_[BUFFER_SIZE];
+    EdgeEncoder encoder_;
+    EdgeReplayer replayer_;
+
+    // Recording bookkeeping. Ring entries are micros() with the new level in bit 0.
+    volatile uint32_t edgeRing_[EDGE_RING_SIZE];
+    volatile uint16_t ringHead_ = 0; // Written by the ISR.
+    volatile uint16_t ringTail_ = 0; // Written by poll().
+    volatile bool ringOverflowed_ = false;
+    bool recording_ = false;
+    bool keep_ = false;
+    bool wakeStart_ = false; // Session backdated by markWakeEdge().
+    uint8_t lineLevel_ = 0;
+    uint32_t lastEdgeUs_ = 0;
+
+    // Flash sink bookkeeping.
+    const esp_partition_t* partition_ = nullptr;
+    size_t partitionOffset_ = 0; // Append point, after the last stored capture.
+    uint32_t storedCaptures_ = 0;
+    size_t storedBytes_ = 0;     // Sum of the stored captures, without gaps.
+
+    bool replaying_ = false;
+    uint8_t replayFlags_ = 0;
+    bool wakePulsePending_ = false;
+};
+
+// The single recorder shared by the sync sub-states. Modal, like the sync protocol itself.
+extern EdgeCapture edgeCapture;
+
+#endif // EDGECAPTURE_H
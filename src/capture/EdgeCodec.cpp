@@ -0,0 +1,189 @@
+#include "EdgeCodec.h"
+#include <string.h>
+
+// Longest LEB128 encoding of a 64-bit value.
+static const size_t MAX_VARINT_BYTES = 10;
+
+void writeEdgeCaptureHeader(uint8_t* out, uint32_t payloadLength, uint8_t flags) {
+    memcpy(out, EDGE_CAPTURE_MAGIC, sizeof(EDGE_CAPTURE_MAGIC));
+    out[4] = EDGE_CAPTURE_VERSION;
+    out[5] = flags;
+    for (int i = 0; i < 4; ++i) {
+        out[6 + i] = static_cast<uint8_t>(payloadLength >> (8 * i));
+    }
+}
+
+bool parseEdgeCaptureHeader(const uint8_t* in, uint32_t& payloadLength, uint8_t* flags) {
+    if (memcmp(in, EDGE_CAPTURE_MAGIC, sizeof(EDGE_CAPTURE_MAGIC)) != 0 || in[4] != EDGE_CAPTURE_VERSION) {
+        return false;
+    }
+    payloadLength = 0;
+    for (int i = 0; i < 4; ++i) {
+        payloadLength |= static_cast<uint32_t>(in[6 + i]) << (8 * i);
+    }
+    if (flags) {
+        *flags = in[5];
+    }
+    return true;
+}
+
+// ============================================================================
+// EdgeEncoder
+// ============================================================================
+
+EdgeEncoder::EdgeEncoder(uint8_t* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity) {}
+
+bool EdgeEncoder::push(uint8_t level, uint32_t durationUs) {
+    if (overflowed_) {
+        return false;
+    }
+    level = level ? 1 : 0;
+
+    // Zigzag maps small negative deltas to small unsigned values.
+    int64_t delta = static_cast<int64_t>(durationUs) - static_cast<int64_t>(previous_[level]);
+    uint64_t value = ((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)) << 1 | level;
+
+    uint8_t encoded[MAX_VARINT_BYTES];
+    size_t length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        encoded[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+
+    if (size_ + length > capacity_) {
+        overflowed_ = true;
+        return false;
+    }
+    memcpy(buffer_ + size_, encoded, length);
+    size_ += length;
+    records_++;
+    previous_[level] = durationUs;
+    return true;
+}
+
+void EdgeEncoder::reset() {
+    size_ = 0;
+    records_ = 0;
+    overflowed_ = false;
+    previous_[0] = previous_[1] = 0;
+}
+
+// ============================================================================
+// EdgeDecoder
+// ============================================================================
+
+EdgeDecoder::EdgeDecoder(const uint8_t* payload, size_t length)
+    : payload_(payload), length_(length) {}
+
+bool EdgeDecoder::next(uint8_t& level, uint32_t& durationUs) {
+    if (malformed_ || offset_ >= length_) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    unsigned int shift = 0;
+    while (true) {
+        if (offset_ >= length_ || shift >= 7 * MAX_VARINT_BYTES) {
+            malformed_ = true; // Truncated or overlong varint.
+            return false;
+        }
+        uint8_t byte = payload_[offset_++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    level = value & 1;
+    uint64_t zigzag = value >> 1;
+    int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    durationUs = static_cast<uint32_t>(static_cast<int64_t>(previous_[level]) + delta);
+    previous_[level] = durationUs;
+    return true;
+}
+
+void EdgeDecoder::rewind() {
+    offset_ = 0;
+    malformed_ = false;
+    previous_[0] = previous_[1] = 0;
+}
+
+// ============================================================================
+// EdgeReplayer
+// ============================================================================
+
+EdgeReplayer::EdgeReplayer(const uint8_t* payload, size_t length)
+    : decoder_(payload, length) {
+    advance();
+}
+
+void EdgeReplayer::rewind() {
+    decoder_.rewind();
+    ended_ = false;
+    edges_ = 0;
+    advance();
+}
+
+// Moves the line to the next segment. Zero-length segments are passed through,
+// so the level seen at any instant is the one the line really held.
+// Past the end the line holds its last level forever.
+bool EdgeReplayer::advance() {
+    uint32_t durationUs;
+    do {
+        if (!decoder_.next(level_, durationUs)) {
+            ended_ = true;
+            return false;
+        }
+        edges_++;
+    } while (durationUs == 0);
+    remainingUs_ = durationUs;
+    return true;
+}
+
+// Consumes line time while (line level == level) == equal.
+// Returns false if the timeout or the end of the timeline was hit first.
+bool EdgeReplayer::skipWhile(uint8_t level, bool equal, unsigned long timeoutUs, unsigned long& elapsedUs) {
+    while ((level_ == level) == equal) {
+        if (ended_) {
+            return false;
+        }
+        if (elapsedUs + remainingUs_ > timeoutUs) {
+            // Stop the virtual clock exactly at the timeout, mid-segment.
+            remainingUs_ -= timeoutUs - elapsedUs;
+            elapsedUs = timeoutUs;
+            return false;
+        }
+        elapsedUs += remainingUs_;
+        advance();
+    }
+    return true;
+}
+
+unsigned long EdgeReplayer::pulseIn(uint8_t level, unsigned long timeoutUs) {
+    level = level ? 1 : 0;
+    unsigned long elapsedUs = 0;
+
+    // Same three phases as pulseIn(): let an ongoing pulse finish, wait for the
+    // pulse to start, then time it until the level changes again.
+    if (!skipWhile(level, true, timeoutUs, elapsedUs) || !skipWhile(level, false, timeoutUs, elapsedUs)) {
+        return 0;
+    }
+    unsigned long startUs = elapsedUs;
+    if (!skipWhile(level, true, timeoutUs, elapsedUs)) {
+        return 0;
+    }
+    return elapsedUs - startUs;
+}
+
+unsigned long EdgeReplayer::ongoingPulse(uint8_t level, unsigned long maxUs) {
+    level = level ? 1 : 0;
+    if (ended_ || level_ != level) {
+        return 0;
+    }
+    unsigned long elapsedUs = 0;
+    skipWhile(level, true, maxUs + 1, elapsedUs);
+    return elapsedUs;
+}
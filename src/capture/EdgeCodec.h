@@ -0,0 +1,164 @@
+// FILE: src/capture/EdgeCodec.h
+
+#ifndef EDGECODEC_H
+#define EDGECODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Edge capture file format
+// ============================================================================
+//
+// All multi-byte header fields are little-endian.
+//
+//   [0..3]  Magic "EDGC".
+//   [4]     Format version (EDGE_CAPTURE_VERSION).
+//   [5]     Flags (EDGE_CAPTURE_FLAG_*). Version 1 writers before the flags left it 0.
+//   [6..9]  Payload length in bytes.
+//   [10..]  Payload: one unsigned LEB128 varint per (level, duration) record.
+//
+// The records form a timeline: each one is the level the RX line held and for
+// how long, from the start of the session to its end, with no gaps.
+//
+// A record is encoded as (zigzag(duration - previousDuration[level]) << 1) | level,
+// where previousDuration starts at 0 for both levels. Consecutive preamble pulses
+// of similar width therefore collapse to a single byte each.
+// Zero-length segments are legal; a replay passes straight through them.
+//
+// This file has no Arduino dependencies so it can also be built on a host.
+
+const uint8_t EDGE_CAPTURE_MAGIC[4] = { 'E', 'D', 'G', 'C' };
+const uint8_t EDGE_CAPTURE_VERSION = 1;
+const size_t EDGE_CAPTURE_HEADER_SIZE = 10;
+
+// The payload ran out of room; the timeline stops before the session ended.
+const uint8_t EDGE_CAPTURE_FLAG_TRUNCATED = 0x01;
+// The recorder missed edges; neighbouring segments were merged, so the timeline
+// no longer matches what the decoder saw live.
+const uint8_t EDGE_CAPTURE_FLAG_EDGES_DROPPED = 0x02;
+// The session began on a light-sleep radio wake. The first segment is the HIGH
+// pulse that woke the CPU, backdated to its estimated rising edge, and the
+// receiver timed it from there (PowerManager::measureWakePulse()) rather than
+// with pulseIn(). A replay must time it the same way.
+const uint8_t EDGE_CAPTURE_FLAG_WAKE_START = 0x04;
+
+/**
+ * @brief Serializes a capture header.
+ * @param out Destination, at least EDGE_CAPTURE_HEADER_SIZE bytes.
+ * @param payloadLength Number of payload bytes that follow the header.
+ * @param flags EDGE_CAPTURE_FLAG_* bits describing the recording.
+ */
+void writeEdgeCaptureHeader(uint8_t* out, uint32_t payloadLength, uint8_t flags = 0);
+
+/**
+ * @brief Validates a capture header and extracts the payload length.
+ * @param in Source, at least EDGE_CAPTURE_HEADER_SIZE bytes.
+ * @param payloadLength Receives the payload length on success.
+ * @param flags If not null, receives the EDGE_CAPTURE_FLAG_* bits on success.
+ * @return false if the magic or version does not match.
+ */
+bool parseEdgeCaptureHeader(const uint8_t* in, uint32_t& payloadLength, uint8_t* flags = nullptr);
+
+/**
+ * @brief Appends delta-varint encoded edge records to a caller-owned buffer.
+ * Never allocates, so it is safe to use from the sync sub-states.
+ */
+class EdgeEncoder {
+public:
+    EdgeEncoder(uint8_t* buffer, size_t capacity);
+
+    /**
+     * @brief Encodes one record.
+     * Once the buffer is full all further records are dropped, so the payload
+     * is always a clean prefix of the session.
+     * @return false if the record did not fit.
+     */
+    bool push(uint8_t level, uint32_t durationUs);
+
+    void reset();
+
+    const uint8_t* data() const { return buffer_; }
+    size_t size() const { return size_; }
+    size_t records() const { return records_; }
+    bool overflowed() const { return overflowed_; }
+
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    size_t records_ = 0;
+    bool overflowed_ = false;
+    uint32_t previous_[2] = { 0, 0 }; // Last duration per level, the delta reference.
+};
+
+/**
+ * @brief Walks a payload produced by EdgeEncoder.
+ */
+class EdgeDecoder {
+public:
+    EdgeDecoder(const uint8_t* payload, size_t length);
+
+    /**
+     * @brief Decodes the next record.
+     * @return false at the end of the payload or on a truncated varint.
+     */
+    bool next(uint8_t& level, uint32_t& durationUs);
+
+    void rewind();
+
+    bool malformed() const { return malformed_; }
+
+private:
+    const uint8_t* payload_;
+    size_t length_;
+    size_t offset_ = 0;
+    bool malformed_ = false;
+    uint32_t previous_[2] = { 0, 0 };
+};
+
+/**
+ * @brief Plays a capture back as a virtual RX line.
+ * The payload is read as a timeline of (level, duration) segments, and
+ * pulseIn() reproduces Arduino pulseIn() semantics against it: an ongoing
+ * pulse of the requested level is skipped, the timeout covers the whole call,
+ * and the virtual clock advances by exactly the line time consumed. A decoder
+ * therefore sees the same pulses however it chooses to read the line.
+ */
+class EdgeReplayer {
+public:
+    EdgeReplayer(const uint8_t* payload, size_t length);
+
+    /**
+     * @brief Measures the next complete pulse of the given level.
+     * @return Pulse duration in us, or 0 on timeout or when the timeline runs out.
+     */
+    unsigned long pulseIn(uint8_t level, unsigned long timeoutUs);
+
+    /**
+     * @brief Times the pulse the line is in right now, from the current position.
+     * Mirrors PowerManager::measureWakePulse(): a pulse still going after maxUs
+     * stops the clock at maxUs + 1.
+     * @return Time until the level changes, or 0 if the line is not at that level.
+     */
+    unsigned long ongoingPulse(uint8_t level, unsigned long maxUs);
+
+    void rewind();
+
+    // Number of timeline segments the line has entered so far.
+    uint32_t getEdges() const { return edges_; }
+    bool ended() const { return ended_; }
+    bool malformed() const { return decoder_.malformed(); }
+
+private:
+    bool advance();
+    bool skipWhile(uint8_t level, bool equal, unsigned long timeoutUs, unsigned long& elapsedUs);
+
+    EdgeDecoder decoder_;
+    uint8_t level_ = 0;
+    uint32_t remainingUs_ = 0; // Line time left in the current segment.
+    bool ended_ = false;
+    uint32_t edges_ = 0;
+};
+
+#endif // EDGECODEC_H
@@ -0,0 +1,125 @@
+#include "PowerManager.h"
+
+// Arduino-free: all pin and sleep access goes through the SleepHal.
+
+PowerManager::PowerManager(SleepHal& hal) : hal_(hal) {}
+
+void PowerManager::begin() {
+    enabled_ = true;
+}
+
+void PowerManager::scheduleWake(unsigned long delayUs) {
+    unsigned long wakeUs = hal_.nowUs() + delayUs;
+    // Signed difference keeps the comparison correct across timer wrap-around.
+    if (!wakeScheduled_ || static_cast<long>(wakeUs - scheduledWakeUs_) < 0) {
+        scheduledWakeUs_ = wakeUs;
+        wakeScheduled_ = true;
+    }
+}
+
+bool PowerManager::consumeTimerWake() {
+    if (timerWakeDue_) {
+        timerWakeDue_ = false;
+        return true;
+    }
+    if (wakeScheduled_ && static_cast<long>(hal_.nowUs() - scheduledWakeUs_) >= 0) {
+        wakeScheduled_ = false;
+        return true;
+    }
+    return false;
+}
+
+WakeSource PowerManager::sleep() {
+    if (!enabled_) {
+        return WakeSource::None;
+    }
+    radioWakePending_ = false;
+
+    unsigned long sleepStartUs = hal_.nowUs();
+    unsigned long sleepUs = MAX_SLEEP_US;
+    bool sleepingUntilSchedule = false;
+    if (wakeScheduled_) {
+        long remainingUs = static_cast<long>(scheduledWakeUs_ - sleepStartUs);
+        if (remainingUs <= static_cast<long>(wakeLatencyUs_)) {
+            // Not worth sleeping: the wake would arrive late anyway.
+            wakeScheduled_ = false;
+            timerWakeDue_ = true;
+            return WakeSource::Timer;
+        }
+        if (static_cast<unsigned long>(remainingUs) < sleepUs) {
+            // Wake early by the expected latency so the work starts on time.
+            sleepUs = remainingUs - wakeLatencyUs_;
+            sleepingUntilSchedule = true;
+        }
+    }
+
+    hal_.armPinWake(WakePin::Radio);
+    hal_.armPinWake(WakePin::Button);
+
+    SleepResult result = hal_.lightSleep(sleepUs);
+    unsigned long wakeUs = hal_.nowUs();
+
+    hal_.disarmPinWake(WakePin::Radio);
+    hal_.disarmPinWake(WakePin::Button);
+
+    if (result.cause == SleepWakeCause::Timer) {
+        // The target time of a timer wake is known, so its latency can be measured.
+        // The timer starts at the actual sleep entry, not when sleep() was called.
+        // The timer may also fire a little early: ESP-IDF trims it by its own
+        // wake overhead. Such samples count as zero latency rather than wrapping.
+        // Fold it into a running average (1/8 weight) to smooth out jitter.
+        long latencyUs = static_cast<long>(wakeUs - (result.entryUs + sleepUs));
+        if (latencyUs < 0) {
+            latencyUs = 0;
+        }
+        wakeLatencyUs_ = (wakeLatencyUs_ * 7 + static_cast<unsigned long>(latencyUs)) / 8;
+
+        if (!sleepingUntilSchedule) {
+            return WakeSource::None; // Plain MAX_SLEEP_US calibration wake.
+        }
+        wakeScheduled_ = false;
+        timerWakeDue_ = true;
+        return WakeSource::Timer;
+    }
+
+    if (result.cause == SleepWakeCause::Gpio) {
+        if (hal_.isPinActive(WakePin::Radio)) {
+            radioWakePending_ = true;
+            radioEdgeUs_ = wakeUs - wakeLatencyUs_;
+            return WakeSource::Radio;
+        }
+        if (hal_.isPinActive(WakePin::Button)) {
+            return WakeSource::Button;
+        }
+    }
+    return WakeSource::None; // Glitch: the level was gone before we could read it.
+}
+
+bool PowerManager::getRadioWakeEdge(unsigned long& edgeUs) const {
+    if (!radioWakePending_) {
+        return false;
+    }
+    edgeUs = radioEdgeUs_;
+    return true;
+}
+
+bool PowerManager::measureWakePulse(unsigned long maxUs, unsigned long& durationUs) {
+    if (!radioWakePending_) {
+        return false;
+    }
+    radioWakePending_ = false;
+    if (!hal_.isPinActive(WakePin::Radio)) {
+        return false;
+    }
+
+    unsigned long handleUs = hal_.nowUs();
+    lastWakeToHandleUs_ = handleUs - radioEdgeUs_;
+    if (lastWakeToHandleUs_ > maxWakeToHandleUs_) {
+        maxWakeToHandleUs_ = lastWakeToHandleUs_;
+    }
+
+    // Busy-wait for the falling edge, just like pulseIn() would.
+    while (hal_.isPinActive(WakePin::Radio) && hal_.nowUs() - radioEdgeUs_ <= maxUs) {}
+    durationUs = hal_.nowUs() - radioEdgeUs_;
+    return true;
+}
@@ -0,0 +1,107 @@
+// FILE: src/power/PowerManager.h
+
+#ifndef POWERMANAGER_H
+#define POWERMANAGER_H
+
+#include "SleepHal.h"
+
+/**
+ * @brief What ended an idle sleep, as seen by IdleState.
+ */
+enum class WakeSource {
+    None,   // Nothing to do: calibration wake, glitch, or low-power idle disabled.
+    Radio,  // RX_PIN went high: an initiation pulse is probably in progress.
+    Button, // BUTTON_PIN was pressed.
+    Timer   // A wake requested with scheduleWake() is due; claimed with consumeTimerWake().
+};
+
+/**
+ * @class PowerManager
+ * @brief Puts the CPU into light sleep while the master FSM is idle and keeps
+ * the wake latency accounting needed by the sync handshake.
+ *
+ * A radio wake happens on the level of the initiation pulse, so its rising edge
+ * is already in the past by the time any code runs. The latency of timer wakes,
+ * whose target time is known exactly, is tracked as a running average and used
+ * to estimate when that edge occurred. measureWakePulse() then times the pulse
+ * from the estimated edge, keeping it inside the INITIATION_PULSE window.
+ */
+class PowerManager {
+public:
+    // Longest single sleep. Timer wakes double as wake latency calibration.
+    static const unsigned long MAX_SLEEP_US = 1000000;
+
+    // Wake latency assumed until the first timer wake has been measured.
+    static const unsigned long DEFAULT_WAKE_LATENCY_US = 1000;
+
+    explicit PowerManager(SleepHal& hal);
+
+    /**
+     * @brief Enables low-power idle. The HAL must already know its pins.
+     */
+    void begin();
+
+    bool isEnabled() const { return enabled_; }
+
+    /**
+     * @brief Requests a timer wake for scheduled work. The earliest request wins.
+     * @param delayUs Time from now until the work is due.
+     */
+    void scheduleWake(unsigned long delayUs);
+
+    /**
+     * @brief Claims a scheduled wake that has come due.
+     * Poll it from the owner of the scheduled work after update(); this also
+     * works with low-power idle disabled, when sleep() never runs.
+     * @return true once per due wake.
+     */
+    bool consumeTimerWake();
+
+    /**
+     * @brief Sleeps until a radio pulse, a button press or a timer wake.
+     * Must be called with the edge ISRs attached; they are restored on return.
+     */
+    WakeSource sleep();
+
+    /**
+     * @brief Times a pulse whose rising edge was slept through.
+     * Only valid once after a WakeSource::Radio wake.
+     * @param maxUs Stop waiting for the falling edge after this long.
+     * @param durationUs Receives the pulse duration measured from the estimated edge.
+     * @return false if there is no pending radio wake or the pulse already ended,
+     *         in which case the caller should fall back to pulseIn().
+     */
+    bool measureWakePulse(unsigned long maxUs, unsigned long& durationUs);
+
+    /**
+     * @brief The estimated rising edge of the pulse behind a pending radio wake.
+     * @return false if there is no pending radio wake.
+     */
+    bool getRadioWakeEdge(unsigned long& edgeUs) const;
+
+    // --- Latency accounting ---
+
+    unsigned long getWakeLatencyUs() const { return wakeLatencyUs_; }
+    unsigned long getLastWakeToHandleUs() const { return lastWakeToHandleUs_; }
+    unsigned long getMaxWakeToHandleUs() const { return maxWakeToHandleUs_; }
+
+private:
+    SleepHal& hal_;
+    bool enabled_ = false;
+
+    bool wakeScheduled_ = false;
+    unsigned long scheduledWakeUs_ = 0;
+    bool timerWakeDue_ = false; // Set by sleep(), cleared by consumeTimerWake().
+
+    bool radioWakePending_ = false;
+    unsigned long radioEdgeUs_ = 0; // Estimated rising edge of the pulse that woke us.
+
+    unsigned long wakeLatencyUs_ = DEFAULT_WAKE_LATENCY_US;
+    unsigned long lastWakeToHandleUs_ = 0;
+    unsigned long maxWakeToHandleUs_ = 0;
+};
+
+// The power manager shared by IdleState and the sync sub-states. Defined in the .ino.
+extern PowerManager powerManager;
+
+#endif // POWERMANAGER_H
@@ -0,0 +1,62 @@
+#include "SleepHal.h"
+#include <Arduino.h>
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+void EspSleepHal::begin(int rxPin, void (*rxIsr)(), int buttonPin, void (*buttonIsr)()) {
+    rxPin_ = rxPin;
+    rxIsr_ = rxIsr;
+    buttonPin_ = buttonPin;
+    buttonIsr_ = buttonIsr;
+}
+
+void EspSleepHal::armPinWake(WakePin pin) {
+    int gpio = pin == WakePin::Radio ? rxPin_ : buttonPin_;
+    // The edge ISR must go first: a level wake source shares the pin's interrupt
+    // type, and an attached handler would fire continuously while the level holds.
+    detachInterrupt(digitalPinToInterrupt(gpio));
+    gpio_wakeup_enable(static_cast<gpio_num_t>(gpio),
+                       pin == WakePin::Radio ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+}
+
+void EspSleepHal::disarmPinWake(WakePin pin) {
+    if (pin == WakePin::Radio) {
+        gpio_wakeup_disable(static_cast<gpio_num_t>(rxPin_));
+        attachInterrupt(digitalPinToInterrupt(rxPin_), rxIsr_, CHANGE);
+    } else {
+        gpio_wakeup_disable(static_cast<gpio_num_t>(buttonPin_));
+        attachInterrupt(digitalPinToInterrupt(buttonPin_), buttonIsr_, FALLING);
+    }
+}
+
+SleepResult EspSleepHal::lightSleep(unsigned long timerUs) {
+    Serial.flush(); // The UART clock stops in light sleep; drain pending log output first.
+
+    // The sleep timer counts from esp_light_sleep_start(), so take the entry time
+    // as close to it as possible; the flush above can take milliseconds.
+    esp_sleep_enable_timer_wakeup(timerUs);
+    SleepResult result;
+    result.entryUs = nowUs();
+    esp_light_sleep_start();
+
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_TIMER: result.cause = SleepWakeCause::Timer; break;
+        case ESP_SLEEP_WAKEUP_GPIO:  result.cause = SleepWakeCause::Gpio; break;
+        default:                     result.cause = SleepWakeCause::Other; break;
+    }
+    return result;
+}
+
+unsigned long EspSleepHal::nowUs() {
+    // esp_timer is compensated for light sleep, unlike the CPU cycle counter.
+    return static_cast<unsigned long>(esp_timer_get_time());
+}
+
+bool EspSleepHal::isPinActive(WakePin pin) {
+    if (pin == WakePin::Radio) {
+        return digitalRead(rxPin_) == HIGH;
+    }
+    return digitalRead(buttonPin_) == LOW;
+}
@@ -0,0 +1,95 @@
+// FILE: src/power/SleepHal.h
+
+#ifndef SLEEPHAL_H
+#define SLEEPHAL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Why the CPU came back from light sleep.
+ */
+enum class SleepWakeCause {
+    Timer,
+    Gpio,
+    Other
+};
+
+/**
+ * @brief The inputs that can wake the CPU, by role. The HAL maps them to pins,
+ * wake levels and edge ISRs, so the power logic never sees Arduino constants.
+ */
+enum class WakePin {
+    Radio,  // Wakes while the radio input is HIGH.
+    Button  // Wakes while the (pulled-up) button input is LOW.
+};
+
+/**
+ * @brief Outcome of one light sleep.
+ */
+struct SleepResult {
+    SleepWakeCause cause;
+    // Time the CPU actually went to sleep, after any pre-sleep work such as
+    // draining the UART. Timer wake latency is measured from here.
+    unsigned long entryUs;
+};
+
+/**
+ * @brief The sleep and wake primitives PowerManager relies on.
+ * Kept as an interface so the latency compensation logic can be driven by a
+ * scripted clock and pin levels instead of real hardware.
+ */
+class SleepHal {
+public:
+    virtual ~SleepHal() = default;
+
+    /**
+     * @brief Detaches the pin's edge ISR and arms it as a level wake source.
+     */
+    virtual void armPinWake(WakePin pin) = 0;
+
+    /**
+     * @brief Disarms the level wake source and re-attaches the pin's edge ISR.
+     */
+    virtual void disarmPinWake(WakePin pin) = 0;
+
+    /**
+     * @brief Enters light sleep and blocks until an armed pin or the timer fires.
+     * @param timerUs Timer wake delay, counted from SleepResult::entryUs.
+     */
+    virtual SleepResult lightSleep(unsigned long timerUs) = 0;
+
+    // Monotonic time that keeps counting through light sleep.
+    virtual unsigned long nowUs() = 0;
+
+    /**
+     * @brief Whether the pin is currently at its wake level.
+     */
+    virtual bool isPinActive(WakePin pin) = 0;
+};
+
+/**
+ * @brief SleepHal backed by the ESP-IDF light sleep API.
+ */
+class EspSleepHal : public SleepHal {
+public:
+    /**
+     * @brief Assigns the pins behind each WakePin.
+     * @param rxIsr Re-attached on CHANGE after each sleep.
+     * @param buttonIsr Re-attached on FALLING after each sleep.
+     */
+    void begin(int rxPin, void (*rxIsr)(), int buttonPin, void (*buttonIsr)());
+
+    void armPinWake(WakePin pin) override;
+    void disarmPinWake(WakePin pin) override;
+    SleepResult lightSleep(unsigned long timerUs) override;
+    unsigned long nowUs() override;
+    bool isPinActive(WakePin pin) override;
+
+private:
+    int rxPin_ = -1;
+    int buttonPin_ = -1;
+    void (*rxIsr_)() = nullptr;
+    void (*buttonIsr_)() = nullptr;
+};
+
+#endif // SLEEPHAL_H
@@ -0,0 +1,21 @@
+// FILE: src/state/Log2Histogram.h
+
+#ifndef LOG2HISTOGRAM_H
+#define LOG2HISTOGRAM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Bucket index of a log2 latency histogram.
+ * Bucket i counts values in [2^i, 2^(i+1)), bucket 0 also holds 0 and the last
+ * bucket is open-ended. Shared by StateProfiler and TxScheduler so their
+ * histograms line up.
+ * @param bucketCount Number of buckets, at least 1.
+ */
+inline uint8_t log2Bucket(uint32_t value, uint8_t bucketCount) {
+    // Position of the highest set bit.
+    uint8_t bucket = value ? 31 - __builtin_clz(value) : 0;
+    return bucket < bucketCount ? bucket : bucketCount - 1;
+}
+
+#endif // LOG2HISTOGRAM_H
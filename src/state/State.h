@@ -4,6 +4,7 @@
 #define STATE_H
 
 #include <any>
+#include <stdint.h>
 
 // Forward declaration to break circular dependency with StateMachine.h.
 template <typename StateIdType>
@@ -32,6 +33,15 @@ public:
      */
     virtual StateIdType getStateId() const = 0;
 
+    // --- Optional overrides ---
+
+    /**
+     * @brief Returns the time budget of a single handle() call.
+     * Only checked while a StateProfiler is attached to the FSM.
+     * @return Budget in microseconds, or 0 if the state has no deadline.
+     */
+    virtual uint32_t getBudgetUs() const { return 0; }
+
     // --- Public methods for FSM interaction ---
 
     /**
@@ -4,9 +4,10 @@
 #define STATEMACHINE_H
 
 #include "State.h"
+#include "StateProfiler.h"
+#include "StatePlatform.h"
 #include <memory>
 #include <unordered_map>
-#include <Arduino.h>
 #include <any>
 
 /**
@@ -51,6 +52,14 @@ public:
      */
     void update();
 
+    /**
+     * @brief Attaches a deadline/WCET profiler, or detaches it with nullptr.
+     * While attached, every handle() call is timed with the CPU cycle counter.
+     * Not ISR-safe; call from setup() or the main loop.
+     * @param profiler The profiler to record into. Must outlive the FSM.
+     */
+    void setProfiler(StateProfiler<StateIdType>* profiler);
+
 private:
     // --- Internal helper methods ---
 
@@ -73,12 +82,23 @@ private:
     // Raw pointer to the currently active state object for fast access.
     State<StateIdType>* currentState_ = nullptr;
     
-    // State tracking IDs. The difference between them signals a transition request.
+    // State tracking IDs. currentStateId_ is the requested state, previousStateId_
+    // the one before the latest request.
     StateIdType currentStateId_;
     StateIdType previousStateId_;
 
+    // The state currentState_ was resolved for. update() only resolves again when
+    // currentStateId_ differs from it, i.e. when a transition is pending.
+    StateIdType activeStateId_;
+
     // A temporary container for a task payload during a state transition.
     std::any currentStateTask_;
+
+    // Optional profiler and the stats slot of the current state. Resolved together with
+    // currentState_ on a transition, so update() does no lookups while a state runs.
+    StateProfiler<StateIdType>* profiler_ = nullptr;
+    StateTimingStats* currentStats_ = nullptr;
+    uint32_t cyclesPerUs_ = 1;
 };
 
 // Implementation is sourced from the .tpp file.
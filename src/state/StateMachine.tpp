@@ -10,7 +10,7 @@
 template <typename StateIdType>
 template <typename... States>
 StateMachine<StateIdType>::StateMachine(StateIdType initialState, States&&... states)
-    : currentStateId_(initialState), previousStateId_(initialState) {
+    : currentStateId_(initialState), previousStateId_(initialState), activeStateId_(initialState) {
     
     // C++17 fold expression to iterate through the passed state objects.
     // For each state, its ID is retrieved via getStateId() and used as a key
@@ -61,38 +61,76 @@ StateIdType StateMachine<StateIdType>::getPreviousStateId() const {
 // if an ISR were to modify the state map concurrently (not our current design, but good practice).
 template <typename StateIdType>
 void StateMachine<StateIdType>::findAndSetCurrentState(StateIdType stateId) {
-    noInterrupts();
+    stateEnterCritical();
     auto it = states_.find(stateId);
-    interrupts();
+    stateExitCritical();
 
     if (it != states_.end()) {
         currentState_ = it->second.get();
     } else {
         currentState_ = nullptr; // Safety: nullify pointer if state not found.
     }
+    activeStateId_ = stateId;
+
+    if (profiler_) {
+        currentStats_ = profiler_->find(stateId);
+    }
+}
+
+// Registers every state and its declared budget with the profiler up front,
+// so that recording in update() never allocates.
+template <typename StateIdType>
+void StateMachine<StateIdType>::setProfiler(StateProfiler<StateIdType>* profiler) {
+    profiler_ = profiler;
+    currentStats_ = nullptr;
+    if (!profiler_) {
+        return;
+    }
+
+    for (auto const& [id, state_ptr] : states_) {
+        if (state_ptr) {
+            profiler_->addState(id, state_ptr->getBudgetUs());
+        }
+    }
+    cyclesPerUs_ = stateCyclesPerUs();
+    currentStats_ = profiler_->find(activeStateId_);
 }
 
 // Delivers the pending task from the FSM to the state object.
+// The task is consumed on delivery: update() runs this step on every call,
+// and a state must see each task exactly once.
 template <typename StateIdType>
 void StateMachine<StateIdType>::setCurrentStateTask() {
-    if (currentState_) {
-        currentState_->setTask(currentStateTask_);
+    if (currentState_ && currentStateTask_.has_value()) {
+        currentState_->setTask(std::move(currentStateTask_));
+        currentStateTask_.reset();
     }
 }
 
 template <typename StateIdType>
 void StateMachine<StateIdType>::update() {
-    // A transition is pending if the current and previous state IDs differ.
-    if (currentStateId_ != previousStateId_) {
+    // A transition is pending if the requested state is not the resolved one.
+    // Read the request once: an ISR may change it while we resolve.
+    StateIdType requestedId = currentStateId_;
+    if (requestedId != activeStateId_) {
         // Update the raw pointer to the new state object.
-        findAndSetCurrentState(currentStateId_);
-        // Deliver the task payload (if any) to the new state.
-        setCurrentStateTask();
+        findAndSetCurrentState(requestedId);
     }
+    // Deliver the task payload (if any), also when re-requesting the current state.
+    setCurrentStateTask();
 
     // Delegate execution to the current state's logic.
     if (currentState_) {
-        currentState_->handle();
+        if (currentStats_) {
+            // Latch the ID first: handle() or an ISR may request a transition.
+            StateIdType handledId = currentState_->getStateId();
+            uint32_t startCycles = stateCycleCount();
+            currentState_->handle();
+            uint32_t elapsedUs = (stateCycleCount() - startCycles) / cyclesPerUs_;
+            profiler_->record(handledId, *currentStats_, elapsedUs);
+        } else {
+            currentState_->handle();
+        }
     }
 }
 
@@ -0,0 +1,35 @@
+// FILE: src/state/StatePlatform.h
+
+#ifndef STATEPLATFORM_H
+#define STATEPLATFORM_H
+
+#include <stdint.h>
+
+// The few platform services StateMachine needs: a critical section around the
+// state map and a cycle counter for the profiler. On the host (native tests)
+// there are no interrupts and the counter runs in microseconds.
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+
+inline void stateEnterCritical() { noInterrupts(); }
+inline void stateExitCritical() { interrupts(); }
+inline uint32_t stateCycleCount() { return ESP.getCycleCount(); }
+inline uint32_t stateCyclesPerUs() { return ESP.getCpuFreqMHz(); }
+
+#else
+
+#include <chrono>
+
+inline void stateEnterCritical() {}
+inline void stateExitCritical() {}
+inline uint32_t stateCycleCount() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+inline uint32_t stateCyclesPerUs() { return 1; }
+
+#endif
+
+#endif // STATEPLATFORM_H
@@ -0,0 +1,80 @@
+// FILE: src/state/StateProfiler.h
+
+#ifndef STATEPROFILER_H
+#define STATEPROFILER_H
+
+#include <stdint.h>
+#include <unordered_map>
+
+/**
+ * @brief Execution time statistics of a single state's handle() calls.
+ * Latencies are binned into log2 buckets: bucket i counts calls that took
+ * [2^i, 2^(i+1)) us, bucket 0 also holds 0 us and the last bucket is open-ended.
+ */
+struct StateTimingStats {
+    static const uint8_t BUCKET_COUNT = 24; // Top bucket starts at ~8.4 s.
+
+    uint32_t budgetUs = 0;  // Declared deadline, 0 if the state has none.
+    uint32_t calls = 0;
+    uint32_t overruns = 0;
+    uint32_t maxUs = 0;     // Worst-case execution time observed so far.
+    uint32_t buckets[BUCKET_COUNT] = {};
+};
+
+/**
+ * @brief Optional deadline monitor and WCET histogram collector for a StateMachine.
+ * Attach it with StateMachine::setProfiler(). All per-state storage is created
+ * on attach, so recording never allocates.
+ * @tparam StateIdType The enum class used for state identification.
+ */
+template <typename StateIdType>
+class StateProfiler {
+public:
+    /**
+     * @brief Called from update() when a handle() call exceeds its state's budget.
+     */
+    using OverrunCallback = void (*)(StateIdType id, uint32_t elapsedUs, uint32_t budgetUs);
+
+    void setOverrunCallback(OverrunCallback callback);
+
+    /**
+     * @brief Registers a state and its budget. Called by StateMachine on attach.
+     * @return The stats slot the machine records into for this state.
+     */
+    StateTimingStats* addState(StateIdType id, uint32_t budgetUs);
+
+    /**
+     * @brief Accounts one handle() call of a state.
+     */
+    void record(StateIdType id, StateTimingStats& stats, uint32_t elapsedUs);
+
+    // --- Runtime queries ---
+
+    StateTimingStats* find(StateIdType id);
+    const StateTimingStats* getStats(StateIdType id) const;
+    uint32_t getTotalOverruns() const;
+
+    /**
+     * @brief Clears all counters and histograms, keeping the declared budgets.
+     */
+    void reset();
+
+    /**
+     * @brief Prints one compact line per state that has run:
+     * "<id> n=<calls> max=<us> budget=<us> over=<n> h=<bucket>:<count>,..."
+     * Only non-empty buckets are listed.
+     * @tparam Output Anything with Arduino Print's printf() and println(), e.g. Serial.
+     */
+    template <typename Output>
+    void dump(Output& out) const;
+
+private:
+    std::unordered_map<StateIdType, StateTimingStats> stats_;
+    OverrunCallback onOverrun_ = nullptr;
+    uint32_t totalOverruns_ = 0;
+};
+
+// Implementation is sourced from the .tpp file.
+#include "StateProfiler.tpp"
+
+#endif // STATEPROFILER_H
@@ -0,0 +1,87 @@
+// FILE: src/state/StateProfiler.tpp
+
+#ifndef STATEPROFILER_TPP
+#define STATEPROFILER_TPP
+
+#include "StateProfiler.h"
+#include "Log2Histogram.h"
+
+template <typename StateIdType>
+void StateProfiler<StateIdType>::setOverrunCallback(OverrunCallback callback) {
+    onOverrun_ = callback;
+}
+
+template <typename StateIdType>
+StateTimingStats* StateProfiler<StateIdType>::addState(StateIdType id, uint32_t budgetUs) {
+    StateTimingStats& stats = stats_[id];
+    stats.budgetUs = budgetUs;
+    return &stats;
+}
+
+// Hot path: runs after every handle() while the profiler is attached.
+template <typename StateIdType>
+void StateProfiler<StateIdType>::record(StateIdType id, StateTimingStats& stats, uint32_t elapsedUs) {
+    stats.buckets[log2Bucket(elapsedUs, StateTimingStats::BUCKET_COUNT)]++;
+    stats.calls++;
+    if (elapsedUs > stats.maxUs) {
+        stats.maxUs = elapsedUs;
+    }
+
+    if (stats.budgetUs && elapsedUs > stats.budgetUs) {
+        stats.overruns++;
+        totalOverruns_++;
+        if (onOverrun_) {
+            onOverrun_(id, elapsedUs, stats.budgetUs);
+        }
+    }
+}
+
+template <typename StateIdType>
+StateTimingStats* StateProfiler<StateIdType>::find(StateIdType id) {
+    auto it = stats_.find(id);
+    return it != stats_.end() ? &it->second : nullptr;
+}
+
+template <typename StateIdType>
+const StateTimingStats* StateProfiler<StateIdType>::getStats(StateIdType id) const {
+    auto it = stats_.find(id);
+    return it != stats_.end() ? &it->second : nullptr;
+}
+
+template <typename StateIdType>
+uint32_t StateProfiler<StateIdType>::getTotalOverruns() const {
+    return totalOverruns_;
+}
+
+template <typename StateIdType>
+void StateProfiler<StateIdType>::reset() {
+    for (auto& [id, stats] : stats_) {
+        uint32_t budgetUs = stats.budgetUs;
+        stats = StateTimingStats();
+        stats.budgetUs = budgetUs;
+    }
+    totalOverruns_ = 0;
+}
+
+template <typename StateIdType>
+template <typename Output>
+void StateProfiler<StateIdType>::dump(Output& out) const {
+    for (auto const& [id, stats] : stats_) {
+        if (stats.calls == 0) {
+            continue; // Skip states that never ran to keep the dump short.
+        }
+        out.printf("%d n=%lu max=%lu budget=%lu over=%lu h=", static_cast<int>(id),
+                   (unsigned long)stats.calls, (unsigned long)stats.maxUs,
+                   (unsigned long)stats.budgetUs, (unsigned long)stats.overruns);
+        bool first = true;
+        for (uint8_t i = 0; i < StateTimingStats::BUCKET_COUNT; ++i) {
+            if (stats.buckets[i]) {
+                out.printf(first ? "%u:%lu" : ",%u:%lu", i, (unsigned long)stats.buckets[i]);
+                first = false;
+            }
+        }
+        out.println();
+    }
+}
+
+#endif // STATEPROFILER_TPP
@@ -15,6 +15,7 @@ enum class SyncStates {
     Timeout,
     Request,
     Initiate,
+    Replay,
 
     // Initiator (Transmitter) path states
     Initiate_SendInitialPulse,
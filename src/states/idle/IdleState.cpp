@@ -1,10 +1,32 @@
 #include "IdleState.h"
 #include "states/StateIds.h" // Include the enum definition
 #include "state/StateMachine.h" // Needed for state transitions
+#include "power/PowerManager.h"
+#include "states/tx/TxScheduler.h"
 #include <Arduino.h>
 
 // This is an explicit instantiation of the template.
 template class IdleState<MasterStates>;
 
 template<typename StateIdType>
-void IdleState<StateIdType>::handle() {}
\ No newline at end of file
+void IdleState<StateIdType>::handle() {
+    // Queued outbound messages take precedence over sleeping.
+    if (txScheduler.hasPending()) {
+        this->machine_->setState(StateIdType::Tx);
+        return;
+    }
+
+    // Without low-power idle this returns immediately and the FSM waits for interrupts.
+    // With it, the CPU sleeps here and the wake source decides the next state, because
+    // the edge that woke us happened while the ISRs were detached.
+    switch (powerManager.sleep()) {
+        case WakeSource::Radio:
+            this->machine_->setState(StateIdType::Sync, SyncStates::Request);
+            break;
+        case WakeSource::Button:
+            this->machine_->setState(StateIdType::Sync, SyncStates::Initiate);
+            break;
+        default:
+            break; // A due Timer wake is claimed by its owner with consumeTimerWake().
+    }
+}
\ No newline at end of file
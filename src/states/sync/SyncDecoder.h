@@ -0,0 +1,118 @@
+// FILE: src/states/sync/SyncDecoder.h
+
+#ifndef SYNCDECODER_H
+#define SYNCDECODER_H
+
+#include "state/State.h"
+#include "state/StateMachine.h"
+#include "SyncLine.h"
+
+// The receiver's decode sub-states and the protocol constants they check.
+// They read the RX line only through a SyncLine, so this file has no Arduino
+// dependencies and the same decoder runs on the device and in host replays.
+
+// ============================================================================
+// Protocol & Timing Constants
+// ============================================================================
+
+// Handshake pulse durations (in microseconds).
+// Defines the valid time windows for the handshake signals.
+const unsigned long INITIATION_PULSE_MIN_US = 15000;
+const unsigned long INITIATION_PULSE_MAX_US = 20000;
+const unsigned long CONFIRMATION_PULSE_MIN_US = 20000;
+const unsigned long CONFIRMATION_PULSE_MAX_US = 25000;
+
+const unsigned int PREAMBLE_PULSE_COUNT = 20; // Number of pulses for clock discovery. More pulses = better average but slower sync.
+const unsigned long PULSE_TIMEOUT_US = 50000; // Max wait time for a single pulse edge. Prevents infinite blocking.
+const unsigned long HANDSHAKE_TIMEOUT_US = 500000; // Max wait time for the initiation and confirmation pulses.
+
+// Deadline monitor budgets for a single handle() call (in microseconds).
+const uint32_t POLLING_BUDGET_US = 2000;
+const uint32_t HANDSHAKE_WAIT_BUDGET_US = HANDSHAKE_TIMEOUT_US + CONFIRMATION_PULSE_MAX_US;
+const uint32_t MEASURE_PREAMBLE_BUDGET_US = PREAMBLE_PULSE_COUNT * 1000 + PULSE_TIMEOUT_US;
+
+// Global variable to share the measured pulse width between receiver and the final synced state.
+// NOTE: This is not thread-safe but acceptable here as sync protocol is modal.
+inline unsigned long discoveredPulseWidth = 0;
+
+// ============================================================================
+// Sub-state definitions
+// ============================================================================
+
+// Sub-state for when the sub-machine has no active task.
+template<typename SubStateIdType>
+class IdleSyncSubState : public State<SubStateIdType> {
+public:
+    void handle() override { /* NOP, consumes no CPU cycles until a new state is set. */ }
+    SubStateIdType getStateId() const override { return SubStateIdType::Idle; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
+};
+
+// Listens for the initial long pulse from an initiator.
+template<typename SubStateIdType>
+class Request_WaitForInitialPulse : public State<SubStateIdType> {
+public:
+    explicit Request_WaitForInitialPulse(SyncLine& line) : line_(&line) {}
+
+    void handle() override {
+        unsigned long duration = 0;
+        if (line_->measureWakePulse(INITIATION_PULSE_MAX_US, duration)) {
+            // We were woken from light sleep by this pulse, so its rising edge is already past.
+            // The duration is measured from the edge estimated by the wake latency instead.
+        } else {
+            duration = line_->readPulse(SYNC_LINE_HIGH, HANDSHAKE_TIMEOUT_US);
+        }
+        if (duration >= INITIATION_PULSE_MIN_US && duration <= INITIATION_PULSE_MAX_US) {
+            // A real initiation, not noise: store this session's capture.
+            line_->keepSession();
+            this->machine_->setState(SubStateIdType::Request_MeasurePreamble);
+        } else {
+            // Timed out, no one is initiating. Return to Idle.
+            this->machine_->setState(SubStateIdType::Idle);
+        }
+    }
+    SubStateIdType getStateId() const override { return SubStateIdType::Request_WaitForInitialPulse; }
+    uint32_t getBudgetUs() const override { return HANDSHAKE_WAIT_BUDGET_US; }
+
+private:
+    SyncLine* line_;
+};
+
+// Measures the incoming preamble pulses to discover the clock rate.
+template<typename SubStateIdType>
+class Request_MeasurePreamble : public State<SubStateIdType> {
+public:
+    explicit Request_MeasurePreamble(SyncLine& line) : line_(&line) {}
+
+    void handle() override {
+        unsigned long totalDuration = 0;
+        unsigned int measuredPulses = 0;
+        for (unsigned int i = 0; i < PREAMBLE_PULSE_COUNT; ++i) {
+            // Time the HIGH phases only. pulseIn() returns just after the falling
+            // edge, so reading the LOW phase next would skip it as already under
+            // way and the following HIGH with it, losing two pulses in three.
+            unsigned long highTime = line_->readPulse(SYNC_LINE_HIGH, PULSE_TIMEOUT_US);
+            if (highTime > 0) {
+                totalDuration += highTime;
+                measuredPulses++;
+            } else {
+                break; // Pulse train ended or timeout occurred.
+            }
+        }
+
+        // Check if enough pulses were measured for a reliable average.
+        if (measuredPulses > PREAMBLE_PULSE_COUNT / 2) {
+            discoveredPulseWidth = totalDuration / measuredPulses;
+            this->machine_->setState(SubStateIdType::Request_SendConfirmation);
+        } else {
+            this->machine_->setState(SubStateIdType::Timeout);
+        }
+    }
+    SubStateIdType getStateId() const override { return SubStateIdType::Request_MeasurePreamble; }
+    uint32_t getBudgetUs() const override { return MEASURE_PREAMBLE_BUDGET_US; }
+
+private:
+    SyncLine* line_;
+};
+
+#endif // SYNCDECODER_H
@@ -0,0 +1,40 @@
+// FILE: src/states/sync/SyncLine.h
+
+#ifndef SYNCLINE_H
+#define SYNCLINE_H
+
+#include <stdint.h>
+
+// Line levels, matching Arduino's HIGH and LOW.
+const uint8_t SYNC_LINE_LOW = 0;
+const uint8_t SYNC_LINE_HIGH = 1;
+
+/**
+ * @brief The RX line as the receiver sub-states see it.
+ * Kept as an interface so the decode path can run against a live radio, a
+ * capture replayed on the device, or a capture replayed on a host.
+ */
+class SyncLine {
+public:
+    virtual ~SyncLine() = default;
+
+    /**
+     * @brief Measures the next complete pulse, with Arduino pulseIn() semantics.
+     * @return Pulse duration in us, or 0 on timeout.
+     */
+    virtual unsigned long readPulse(uint8_t level, unsigned long timeoutUs) = 0;
+
+    /**
+     * @brief Times the HIGH pulse that woke the CPU from light sleep, if any.
+     * Mirrors PowerManager::measureWakePulse().
+     * @return false if this session did not start on a radio wake.
+     */
+    virtual bool measureWakePulse(unsigned long maxUs, unsigned long& durationUs) = 0;
+
+    /**
+     * @brief The session is a real initiation; its capture is worth keeping.
+     */
+    virtual void keepSession() {}
+};
+
+#endif // SYNCLINE_H
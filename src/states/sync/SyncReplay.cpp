@@ -0,0 +1,88 @@
+#include "SyncReplay.h"
+#include "SyncDecoder.h"
+#include "capture/EdgeCodec.h"
+
+namespace {
+
+/**
+ * @brief A SyncLine played back from a capture timeline.
+ * Like EdgeCapture's on-device replay, a wake-start capture times its first
+ * pulse once as the wake pulse, and pulseIn() semantics apply from there on.
+ */
+class ReplaySyncLine : public SyncLine {
+public:
+    ReplaySyncLine(EdgeReplayer& replayer, bool wakeStart)
+        : replayer_(replayer), wakePulsePending_(wakeStart) {}
+
+    unsigned long readPulse(uint8_t level, unsigned long timeoutUs) override {
+        return replayer_.pulseIn(level, timeoutUs);
+    }
+
+    bool measureWakePulse(unsigned long maxUs, unsigned long& durationUs) override {
+        if (!wakePulsePending_) {
+            return false;
+        }
+        wakePulsePending_ = false;
+        durationUs = replayer_.ongoingPulse(SYNC_LINE_HIGH, maxUs);
+        return durationUs != 0;
+    }
+
+private:
+    EdgeReplayer& replayer_;
+    bool wakePulsePending_;
+};
+
+// Stands in for the sub-states after the decode path, which would drive the
+// transmitter or log; reaching one ends the replay.
+template<typename SubStateIdType>
+class ReplayEndSubState : public State<SubStateIdType> {
+public:
+    explicit ReplayEndSubState(SubStateIdType id) : id_(id) {}
+    void handle() override {}
+    SubStateIdType getStateId() const override { return id_; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
+
+private:
+    SubStateIdType id_;
+};
+
+bool isReplayEnd(SyncStates state) {
+    return state == SyncStates::Idle || state == SyncStates::Timeout ||
+           state == SyncStates::Request_SendConfirmation;
+}
+
+} // namespace
+
+bool replaySyncCapture(const uint8_t* file, size_t length, SyncReplayResult& result) {
+    uint32_t payloadLength = 0;
+    uint8_t flags = 0;
+    if (length < EDGE_CAPTURE_HEADER_SIZE || !parseEdgeCaptureHeader(file, payloadLength, &flags) ||
+        payloadLength > length - EDGE_CAPTURE_HEADER_SIZE) {
+        return false;
+    }
+
+    EdgeReplayer replayer(file + EDGE_CAPTURE_HEADER_SIZE, payloadLength);
+    ReplaySyncLine line(replayer, (flags & EDGE_CAPTURE_FLAG_WAKE_START) != 0);
+    StateMachine<SyncStates> machine(
+        SyncStates::Idle,
+        IdleSyncSubState<SyncStates>(),
+        ReplayEndSubState<SyncStates>(SyncStates::Timeout),
+        ReplayEndSubState<SyncStates>(SyncStates::Request_SendConfirmation),
+        Request_WaitForInitialPulse<SyncStates>(line),
+        Request_MeasurePreamble<SyncStates>(line)
+    );
+
+    discoveredPulseWidth = 0;
+    machine.setState(SyncStates::Request_WaitForInitialPulse);
+    // Each decode sub-state hands over after one handle(), so this ends in two steps.
+    while (!isReplayEnd(machine.getCurrentStateId())) {
+        machine.update();
+    }
+
+    result.outcome = machine.getCurrentStateId();
+    result.pulseWidthUs = discoveredPulseWidth;
+    result.edges = replayer.getEdges();
+    result.flags = flags;
+    result.malformed = replayer.malformed();
+    return true;
+}
@@ -0,0 +1,35 @@
+// FILE: src/states/sync/SyncReplay.h
+
+#ifndef SYNCREPLAY_H
+#define SYNCREPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "states/StateIds.h"
+
+/**
+ * @brief What the receiver decoded from one replayed capture.
+ */
+struct SyncReplayResult {
+    // Where the decoder stopped: Request_SendConfirmation if it accepted the
+    // handshake, Idle if it rejected the initiation, Timeout if the preamble
+    // was too short.
+    SyncStates outcome = SyncStates::Idle;
+    unsigned long pulseWidthUs = 0; // discoveredPulseWidth, 0 unless accepted.
+    uint32_t edges = 0;             // Timeline segments consumed.
+    uint8_t flags = 0;              // EDGE_CAPTURE_FLAG_* bits from the header.
+    bool malformed = false;         // The payload ended inside a record.
+};
+
+/**
+ * @brief Runs one capture through the receiver's decode sub-states.
+ * Drives the same Request_WaitForInitialPulse and Request_MeasurePreamble the
+ * device uses (SyncDecoder.h), fed by an EdgeReplayer as fast as the host can
+ * go, and stops where the device would key its transmitter or give up. Builds
+ * on a host, so recorded captures can serve as a regression corpus.
+ * @param file A whole capture file, header included.
+ * @return false if the header is invalid or the payload is cut short.
+ */
+bool replaySyncCapture(const uint8_t* file, size_t length, SyncReplayResult& result);
+
+#endif // SYNCREPLAY_H
@@ -1,9 +1,12 @@
 #include "SyncState.h"
+#include "SyncDecoder.h"
 #include "states/StateIds.h"
 #include "state/StateMachine.h"
 #include <Arduino.h>
 #include <any>
 #include "esp_timer.h" // Required for hardware timers
+#include "capture/EdgeCapture.h"
+#include "power/PowerManager.h"
 
 // ============================================================================
 // Protocol & Timing Constants
@@ -12,24 +15,58 @@ const int TX_PIN = 5; // GPIO for the transmitter data line.
 const int RX_PIN = 4; // GPIO for the receiver data line.
 const int LED_BUILTIN = 8; // Onboard LED for the ESP32-C3.
 
-// Handshake pulse durations (in microseconds).
-// Defines the valid time windows for the handshake signals.
-const unsigned long INITIATION_PULSE_MIN_US = 15000;
-const unsigned long INITIATION_PULSE_MAX_US = 20000;
-const unsigned long CONFIRMATION_PULSE_MIN_US = 20000;
-const unsigned long CONFIRMATION_PULSE_MAX_US = 25000;
+// The handshake windows and the receiver's budgets live in SyncDecoder.h.
 
-const unsigned int PREAMBLE_PULSE_COUNT = 20; // Number of pulses for clock discovery. More pulses = better average but slower sync.
-const unsigned long PULSE_TIMEOUT_US = 50000; // Max wait time for a single pulse edge. Prevents infinite blocking.
+// Deadline monitor budgets for a single handle() call (in microseconds).
+// Blocking states are allowed their nominal on-air or wait time plus slack;
+// polling states are expected to return almost immediately.
+const uint32_t INITIAL_PULSE_BUDGET_US = 20000;
+const uint32_t PREAMBLE_BUDGET_US = PREAMBLE_PULSE_COUNT * 1000 + 2000;
+const uint32_t CONFIRMATION_BUDGET_US = 25000;
 
-// Global variable to share the measured pulse width between receiver and the final synced state.
-// NOTE: This is not thread-safe but acceptable here as sync protocol is modal.
-unsigned long discoveredPulseWidth = 0;
+// Deadline/WCET statistics of the sync sub-states. Attached only with -DSTATE_PROFILING.
+StateProfiler<SyncStates> syncProfiler;
 
 // Forward declaration of the ISR function from the main .ino file
 // This is needed to re-attach the interrupt later.
 void IRAM_ATTR handleRadioPulse();
 
+/**
+ * @brief Measures one pulse on RX_PIN for the sync sub-states.
+ * Wraps pulseIn() so pulses are served from a loaded capture instead of the
+ * radio while a replay is running. While recording, the edges seen during the
+ * blocking wait are drained into the capture straight away.
+ */
+static unsigned long readPulse(uint8_t level, unsigned long timeoutUs) {
+    if (edgeCapture.isReplaying()) {
+        return edgeCapture.replayPulse(level, timeoutUs);
+    }
+    unsigned long duration = pulseIn(RX_PIN, level, timeoutUs);
+    edgeCapture.poll();
+    return duration;
+}
+
+/**
+ * @brief RX_PIN as the receiver sub-states (SyncDecoder.h) see it on the device.
+ * Serves the radio, or the loaded capture while a replay is running.
+ */
+class RadioSyncLine : public SyncLine {
+public:
+    unsigned long readPulse(uint8_t level, unsigned long timeoutUs) override {
+        return ::readPulse(level, timeoutUs);
+    }
+
+    bool measureWakePulse(unsigned long maxUs, unsigned long& durationUs) override {
+        return edgeCapture.isReplaying()
+            ? edgeCapture.replayWakePulse(maxUs, durationUs)
+            : powerManager.measureWakePulse(maxUs, durationUs);
+    }
+
+    void keepSession() override { edgeCapture.keepSession(); }
+};
+
+static RadioSyncLine radioLine;
+
 
 // ============================================================================
 // Sub-state definitions
@@ -37,14 +74,6 @@ void IRAM_ATTR handleRadioPulse();
 
 // --- Shared Final States ---
 
-// Sub-state for when the sub-machine has no active task.
-template<typename SubStateIdType>
-class IdleSyncSubState : public State<SubStateIdType> {
-public:
-    void handle() override { /* NOP, consumes no CPU cycles until a new state is set. */ }
-    SubStateIdType getStateId() const override { return SubStateIdType::Idle; }
-};
-
 // Sub-state for handling synchronization failures.
 template<typename SubStateIdType>
 class TimeoutSyncSubState : public State<SubStateIdType> {
@@ -56,6 +85,7 @@ public:
         this->machine_->setState(SubStateIdType::Idle);
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Timeout; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
 };
 
 /**
@@ -122,6 +152,7 @@ public:
     }
 
     SubStateIdType getStateId() const override { return SubStateIdType::Synced; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
 };
 
 // Static member initialization.
@@ -136,12 +167,14 @@ template<typename SubStateIdType>
 class Initiate_SendInitialPulse : public State<SubStateIdType> {
 public:
     void handle() override {
+        edgeCapture.keepSession(); // Initiations are deliberate; always worth keeping.
         digitalWrite(TX_PIN, HIGH);
         delayMicroseconds(17500); // 17.5ms pulse
         digitalWrite(TX_PIN, LOW);
         this->machine_->setState(SubStateIdType::Initiate_SendPreamble);
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Initiate_SendInitialPulse; }
+    uint32_t getBudgetUs() const override { return INITIAL_PULSE_BUDGET_US; }
 };
 
 // Sends a burst of known-width pulses for the receiver to measure.
@@ -160,6 +193,7 @@ public:
         this->machine_->setState(SubStateIdType::Initiate_WaitForConfirmation);
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Initiate_SendPreamble; }
+    uint32_t getBudgetUs() const override { return PREAMBLE_BUDGET_US; }
 };
 
 // Waits for the receiver's confirmation pulse.
@@ -168,7 +202,7 @@ class Initiate_WaitForConfirmation : public State<SubStateIdType> {
 public:
     void handle() override {
         // Block and wait for a pulse within the expected time window.
-        unsigned long duration = pulseIn(RX_PIN, HIGH, 500000);
+        unsigned long duration = readPulse(HIGH, HANDSHAKE_TIMEOUT_US);
         if (duration >= CONFIRMATION_PULSE_MIN_US && duration <= CONFIRMATION_PULSE_MAX_US) {
             this->machine_->setState(SubStateIdType::Initiate_SendFinalTrigger);
         } else {
@@ -176,6 +210,7 @@ public:
         }
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Initiate_WaitForConfirmation; }
+    uint32_t getBudgetUs() const override { return HANDSHAKE_WAIT_BUDGET_US; }
 };
 
 /**
@@ -229,6 +264,7 @@ public:
         }
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Initiate_SendFinalTrigger; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
 };
 template<typename SubStateIdType>
 volatile bool Initiate_SendFinalTrigger<SubStateIdType>::pulseSent = false;
@@ -236,63 +272,25 @@ volatile bool Initiate_SendFinalTrigger<SubStateIdType>::pulseSent = false;
 
 // --- REQUEST (Receiver) Path States ---
 
-// Listens for the initial long pulse from an initiator.
-template<typename SubStateIdType>
-class Request_WaitForInitialPulse : public State<SubStateIdType> {
-public:
-    void handle() override {
-        unsigned long duration = pulseIn(RX_PIN, HIGH, 500000);
-        if (duration >= INITIATION_PULSE_MIN_US && duration <= INITIATION_PULSE_MAX_US) {
-            this->machine_->setState(SubStateIdType::Request_MeasurePreamble);
-        } else {
-            // Timed out, no one is initiating. Return to Idle.
-            this->machine_->setState(SubStateIdType::Idle);
-        }
-    }
-    SubStateIdType getStateId() const override { return SubStateIdType::Request_WaitForInitialPulse; }
-};
-
-// Measures the incoming preamble pulses to discover the clock rate.
-template<typename SubStateIdType>
-class Request_MeasurePreamble : public State<SubStateIdType> {
-public:
-    void handle() override {
-        unsigned long totalDuration = 0;
-        unsigned int measuredPulses = 0;
-        for (unsigned int i = 0; i < PREAMBLE_PULSE_COUNT; ++i) {
-            // Measure both high and low phases of the pulse.
-            unsigned long highTime = pulseIn(RX_PIN, HIGH, PULSE_TIMEOUT_US);
-            unsigned long lowTime = pulseIn(RX_PIN, LOW, PULSE_TIMEOUT_US);
-            if (highTime > 0 && lowTime > 0) {
-                totalDuration += highTime + lowTime;
-                measuredPulses++;
-            } else {
-                break; // Pulse train ended or timeout occurred.
-            }
-        }
-
-        // Check if enough pulses were measured for a reliable average.
-        if (measuredPulses > PREAMBLE_PULSE_COUNT / 2) {
-            discoveredPulseWidth = (totalDuration / measuredPulses) / 2;
-            this->machine_->setState(SubStateIdType::Request_SendConfirmation);
-        } else {
-            this->machine_->setState(SubStateIdType::Timeout);
-        }
-    }
-    SubStateIdType getStateId() const override { return SubStateIdType::Request_MeasurePreamble; }
-};
+// Request_WaitForInitialPulse and Request_MeasurePreamble are in SyncDecoder.h.
 
 // Sends the long confirmation pulse back to the initiator.
 template<typename SubStateIdType>
 class Request_SendConfirmation : public State<SubStateIdType> {
 public:
     void handle() override {
+        if (edgeCapture.isReplaying()) {
+            // Replay only exercises the decoding path; never key the transmitter.
+            this->machine_->setState(SubStateIdType::Idle);
+            return;
+        }
         digitalWrite(TX_PIN, HIGH);
         delayMicroseconds(22500); // 22.5ms pulse.
         digitalWrite(TX_PIN, LOW);
         this->machine_->setState(SubStateIdType::Request_WaitForFinalTrigger);
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Request_SendConfirmation; }
+    uint32_t getBudgetUs() const override { return CONFIRMATION_BUDGET_US; }
 };
 
 /**
@@ -327,7 +325,7 @@ public:
         if (!timerStarted) {
             Serial.println("  Sub-State: Waiting for final trigger (non-blocking)...");
             // Start a timer for the maximum wait time.
-            esp_timer_start_once(timeoutTimer, 500000); // 500ms timeout
+            esp_timer_start_once(timeoutTimer, HANDSHAKE_TIMEOUT_US);
             timerStarted = true;
             timedOut = false;
         }
@@ -352,6 +350,7 @@ public:
         }
     }
     SubStateIdType getStateId() const override { return SubStateIdType::Request_WaitForFinalTrigger; }
+    uint32_t getBudgetUs() const override { return POLLING_BUDGET_US; }
 };
 template<typename SubStateIdType>
 volatile bool Request_WaitForFinalTrigger<SubStateIdType>::timedOut = false;
@@ -374,11 +373,20 @@ SyncState<StateIdType>::SyncState() {
         Initiate_SendPreamble<SyncStates>(),
         Initiate_WaitForConfirmation<SyncStates>(),
         Initiate_SendFinalTrigger<SyncStates>(),
-        Request_WaitForInitialPulse<SyncStates>(),
-        Request_MeasurePreamble<SyncStates>(),
+        Request_WaitForInitialPulse<SyncStates>(radioLine),
+        Request_MeasurePreamble<SyncStates>(radioLine),
         Request_SendConfirmation<SyncStates>(),
         Request_WaitForFinalTrigger<SyncStates>()
     );
+#ifdef STATE_PROFILING
+    subMachine_->setProfiler(&syncProfiler);
+#endif
+}
+
+template<typename StateIdType>
+uint32_t SyncState<StateIdType>::getBudgetUs() const {
+    // One master update runs one sub-state handle(); the longest is a handshake wait.
+    return HANDSHAKE_WAIT_BUDGET_US + POLLING_BUDGET_US;
 }
 
 template<typename StateIdType>
@@ -399,9 +407,16 @@ void SyncState<StateIdType>::handle() {
             // Set the initial state of the sub-machine based on the task.
             if (task == SyncStates::Initiate) {
                 subMachine_->setState(SyncStates::Initiate_SendInitialPulse); 
-            } else if (task == SyncStates::Request) {
+            } else if (task == SyncStates::Request || task == SyncStates::Replay) {
+                // A replay drives the same receiver path, fed from the loaded capture.
                 subMachine_->setState(SyncStates::Request_WaitForInitialPulse);
             }
+            edgeCapture.beginSession();
+            unsigned long wakeEdgeUs;
+            if (task == SyncStates::Request && powerManager.getRadioWakeEdge(wakeEdgeUs)) {
+                // The capture must start at the pulse's rising edge, like the live measurement.
+                edgeCapture.markWakeEdge(wakeEdgeUs);
+            }
         } catch (const std::bad_any_cast& e) {
             Serial.println("SyncState: Error while casting task payload.");
         }
@@ -409,12 +424,36 @@ void SyncState<StateIdType>::handle() {
     }
 
     // Delegate execution to the sub-state machine.
-    if (subMachine_) {
+    unsigned long replayUs = 0;
+    if (subMachine_ && edgeCapture.isReplaying()) {
+        // Drive the decoder in a tight loop so the timing covers the sub-states only.
+        discoveredPulseWidth = 0;
+        unsigned long startUs = micros();
+        while (subMachine_->getCurrentStateId() != SyncStates::Idle) {
+            subMachine_->update();
+        }
+        replayUs = micros() - startUs;
+    } else if (subMachine_) {
         subMachine_->update();
+        edgeCapture.poll();
     }
     
     // Check if the sub-machine has completed its work (returned to Idle).
     if (subMachine_ && subMachine_->getCurrentStateId() == SyncStates::Idle) {
+        if (edgeCapture.isReplaying()) {
+            uint32_t edges = edgeCapture.getReplayedEdges();
+            Serial.printf("SyncState: Replayed %lu edges in %lu us", (unsigned long)edges, replayUs);
+            if (replayUs > 0) {
+                Serial.printf(" (%lu edges/s)", (unsigned long)((uint64_t)edges * 1000000ULL / replayUs));
+            }
+            uint8_t flags = edgeCapture.getReplayFlags();
+            Serial.printf(", decoded pulse width %lu us%s%s%s.\n", discoveredPulseWidth,
+                          edgeCapture.isReplayMalformed() ? ", capture malformed" : "",
+                          flags & EDGE_CAPTURE_FLAG_TRUNCATED ? ", capture truncated" : "",
+                          flags & EDGE_CAPTURE_FLAG_EDGES_DROPPED ? ", edges dropped while recording" : "");
+        }
+        edgeCapture.endSession();
+
         // --- CRITICAL SECTION END: Re-enable interrupt after sync process ---
         attachInterrupt(digitalPinToInterrupt(RX_PIN), handleRadioPulse, CHANGE);
         Serial.println("SyncState: RX Interrupt re-attached.");
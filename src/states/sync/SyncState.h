@@ -2,6 +2,7 @@
 #define SYNCSTATE_H
 
 #include "state/State.h"
+#include "state/StateProfiler.h"
 #include "states/StateIds.h"
 #include <any>
 
@@ -42,11 +43,19 @@ public:
         return StateIdType::Sync;
     }
 
+    /**
+     * @brief Budget for one handle() call, bounded by the longest blocking sub-state.
+     */
+    uint32_t getBudgetUs() const override;
+
 protected:
     friend class StateMachine<StateIdType>; // Allow StateMachine to access private members
     StateMachine<SyncStates>* subMachine_ = nullptr;
 };
 
+// Deadline/WCET statistics of the sync sub-machine (see StateProfiler).
+extern StateProfiler<SyncStates> syncProfiler;
+
 template<typename SubStateIdType>
 class IdleSyncSubState;
 
@@ -0,0 +1,112 @@
+#include "TxScheduler.h"
+#include "state/Log2Histogram.h"
+#include <string.h>
+
+TxScheduler txScheduler;
+
+bool TxScheduler::enqueue(TxPriority priority, const uint8_t* data, size_t length, unsigned long nowUs) {
+    return enqueue(priority, data, length, nowUs, TX_DEFAULT_MAX_AGE_US[static_cast<uint8_t>(priority)]);
+}
+
+bool TxScheduler::enqueue(TxPriority priority, const uint8_t* data, size_t length, unsigned long nowUs, unsigned long maxAgeUs) {
+    if (length == 0 || length > TX_MAX_MESSAGE_SIZE) {
+        return false;
+    }
+
+    Queue& queue = queues_[static_cast<uint8_t>(priority)];
+    if (queue.count == TX_QUEUE_DEPTH) {
+        queue.stats.rejectedFull++;
+        return false;
+    }
+
+    Slot& slot = queue.slots[(queue.head + queue.count) % TX_QUEUE_DEPTH];
+    memcpy(slot.data, data, length);
+    slot.length = length;
+    slot.offset = 0;
+    slot.enqueuedUs = nowUs;
+    slot.maxAgeUs = maxAgeUs;
+    queue.count++;
+    queue.stats.enqueued++;
+    return true;
+}
+
+bool TxScheduler::hasPending() const {
+    for (uint8_t c = 0; c < TX_PRIORITY_COUNT; ++c) {
+        if (queues_[c].count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TxScheduler::nextFrame(unsigned long nowUs, TxFrame& frame) {
+    inFlightClass_ = -1;
+
+    for (uint8_t c = 0; c < TX_PRIORITY_COUNT; ++c) {
+        Queue& queue = queues_[c];
+
+        // Drop stale messages at the head. A message already partly on air is
+        // always finished, otherwise the frames sent so far would be wasted.
+        while (queue.count) {
+            Slot& head = queue.slots[queue.head];
+            if (head.offset || !head.maxAgeUs || nowUs - head.enqueuedUs <= head.maxAgeUs) {
+                break;
+            }
+            queue.stats.droppedStale++;
+            pop(queue);
+        }
+        if (!queue.count) {
+            continue;
+        }
+
+        Slot& head = queue.slots[queue.head];
+        size_t remaining = head.length - head.offset;
+        inFlightClass_ = c;
+        inFlightLength_ = remaining < TX_FRAME_PAYLOAD ? remaining : TX_FRAME_PAYLOAD;
+
+        frame.data = head.data + head.offset;
+        frame.length = inFlightLength_;
+        frame.priority = static_cast<TxPriority>(c);
+        frame.first = head.offset == 0;
+        frame.last = inFlightLength_ == remaining;
+        return true;
+    }
+    return false;
+}
+
+void TxScheduler::frameSent(unsigned long nowUs) {
+    if (inFlightClass_ < 0) {
+        return;
+    }
+    Queue& queue = queues_[inFlightClass_];
+    Slot& head = queue.slots[queue.head];
+    inFlightClass_ = -1;
+
+    head.offset += inFlightLength_;
+    if (head.offset < head.length) {
+        return; // More frames to go; the class is re-chosen before the next one.
+    }
+
+    uint32_t latencyUs = nowUs - head.enqueuedUs;
+    queue.stats.latencyBuckets[log2Bucket(latencyUs, TxClassStats::BUCKET_COUNT)]++;
+    if (latencyUs > queue.stats.maxLatencyUs) {
+        queue.stats.maxLatencyUs = latencyUs;
+    }
+    queue.stats.sent++;
+    pop(queue);
+}
+
+const TxClassStats& TxScheduler::getStats(TxPriority priority) const {
+    return queues_[static_cast<uint8_t>(priority)].stats;
+}
+
+void TxScheduler::resetStats() {
+    for (uint8_t c = 0; c < TX_PRIORITY_COUNT; ++c) {
+        queues_[c].stats = TxClassStats();
+    }
+}
+
+void TxScheduler::pop(Queue& queue) {
+    queue.head = (queue.head + 1) % TX_QUEUE_DEPTH;
+    queue.count--;
+}
@@ -0,0 +1,145 @@
+// FILE: src/states/tx/TxScheduler.h
+
+#ifndef TXSCHEDULER_H
+#define TXSCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Scheduler Configuration
+// ============================================================================
+
+/**
+ * @brief Outbound QoS classes, highest priority first.
+ */
+enum class TxPriority : uint8_t {
+    Alarm,   // Never dropped for age, always sent next.
+    Control, // Protocol and status traffic.
+    Bulk     // Large uploads; yields to everything else between frames.
+};
+
+const uint8_t TX_PRIORITY_COUNT = 3;
+const size_t TX_QUEUE_DEPTH = 4;         // Message slots per class, preallocated.
+const size_t TX_MAX_MESSAGE_SIZE = 256;  // Largest message accepted by enqueue().
+const size_t TX_FRAME_PAYLOAD = 16;      // Message bytes per frame, the preemption granularity.
+
+// Default maximum queueing age per class before an unsent message is dropped. 0 = never.
+const unsigned long TX_DEFAULT_MAX_AGE_US[TX_PRIORITY_COUNT] = { 0, 2000000, 30000000 };
+
+// ============================================================================
+// Frame Airtime
+// ============================================================================
+// A frame is a start marker, one LOW bit period, then the header and payload
+// bytes in Manchester code. See TxState.cpp for the line coding.
+
+const unsigned long TX_BIT_US = 500;           // One data bit, two half-bit levels.
+const unsigned long TX_START_MARKER_US = 2000; // Unbroken HIGH that opens every frame.
+const size_t TX_FRAME_HEADER_BYTES = 2;        // Flags and payload length.
+
+/**
+ * @brief On-air time of one frame carrying payloadLength message bytes.
+ */
+inline unsigned long txFrameAirtimeUs(size_t payloadLength) {
+    return TX_START_MARKER_US + TX_BIT_US + (TX_FRAME_HEADER_BYTES + payloadLength) * 8 * TX_BIT_US;
+}
+
+/**
+ * @brief One frame handed to TxState for transmission.
+ * data points into the scheduler's slot and stays valid until frameSent().
+ */
+struct TxFrame {
+    const uint8_t* data;
+    uint8_t length;
+    TxPriority priority;
+    bool first; // First frame of its message.
+    bool last;  // Last frame of its message.
+};
+
+/**
+ * @brief Per-class queueing statistics.
+ * Latency runs from enqueue() to frameSent() of the message's last frame and is
+ * binned with log2Bucket() like StateTimingStats: bucket i counts [2^i, 2^(i+1)) us.
+ */
+struct TxClassStats {
+    static const uint8_t BUCKET_COUNT = 26; // Top bucket starts at ~33.5 s.
+
+    uint32_t enqueued = 0;
+    uint32_t sent = 0;
+    uint32_t droppedStale = 0; // Exceeded their maximum age before the first frame went out.
+    uint32_t rejectedFull = 0; // Refused by enqueue() because the class queue was full.
+    uint32_t maxLatencyUs = 0;
+    uint32_t latencyBuckets[BUCKET_COUNT] = {};
+};
+
+/**
+ * @class TxScheduler
+ * @brief Strict-priority scheduler for the half-duplex OOK channel.
+ *
+ * Every class owns a fixed ring of message slots, so nothing is allocated at
+ * runtime. Messages are cut into frames of TX_FRAME_PAYLOAD bytes and the class
+ * is re-chosen before every frame: an alarm queued during a bulk upload goes
+ * out after the current frame, and the upload resumes where it left off.
+ * Not ISR-safe; use it from the main loop only. Time is passed in by the caller.
+ */
+class TxScheduler {
+public:
+    /**
+     * @brief Copies a message into its class queue with the class's default maximum age.
+     * @return false if the message is empty, too large, or the queue is full.
+     */
+    bool enqueue(TxPriority priority, const uint8_t* data, size_t length, unsigned long nowUs);
+
+    /**
+     * @brief Copies a message into its class queue.
+     * @param maxAgeUs Drop the message if its first frame has not gone out by then. 0 = never.
+     */
+    bool enqueue(TxPriority priority, const uint8_t* data, size_t length, unsigned long nowUs, unsigned long maxAgeUs);
+
+    bool hasPending() const;
+
+    /**
+     * @brief Picks the next frame from the highest-priority non-empty class.
+     * Stale messages found on the way are dropped and counted.
+     * @return false if there is nothing left to send.
+     */
+    bool nextFrame(unsigned long nowUs, TxFrame& frame);
+
+    /**
+     * @brief Confirms that the frame returned by nextFrame() is on air.
+     * Completes the message after its last frame.
+     */
+    void frameSent(unsigned long nowUs);
+
+    const TxClassStats& getStats(TxPriority priority) const;
+    void resetStats();
+
+private:
+    struct Slot {
+        uint8_t data[TX_MAX_MESSAGE_SIZE];
+        uint16_t length;
+        uint16_t offset; // Bytes already sent. Non-zero means the message is in progress.
+        unsigned long enqueuedUs;
+        unsigned long maxAgeUs;
+    };
+
+    struct Queue {
+        Slot slots[TX_QUEUE_DEPTH];
+        uint8_t head = 0;
+        uint8_t count = 0;
+        TxClassStats stats;
+    };
+
+    void pop(Queue& queue);
+
+    Queue queues_[TX_PRIORITY_COUNT];
+
+    // Class and size of the frame handed out by nextFrame(), -1 if none.
+    int inFlightClass_ = -1;
+    uint8_t inFlightLength_ = 0;
+};
+
+// The outbound queue shared by the application and TxState.
+extern TxScheduler txScheduler;
+
+#endif // TXSCHEDULER_H
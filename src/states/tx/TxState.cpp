@@ -0,0 +1,93 @@
+#include "TxState.h"
+#include "TxScheduler.h"
+#include "states/StateIds.h"
+#include "state/StateMachine.h"
+#include <Arduino.h>
+
+// ============================================================================
+// Framing & Timing Constants
+// ============================================================================
+//
+// Line coding: every bit is sent in Manchester code (IEEE 802.3 convention:
+// 1 = LOW then HIGH, 0 = HIGH then LOW, TX_BIT_US / 2 per half), so the line
+// changes level at least once per bit and a HIGH run inside the data never
+// exceeds one bit period (500 us). The only longer HIGH is the start marker
+// (TX_START_MARKER_US, 2 ms), which is a code violation and cannot appear in
+// the data.
+//
+// Telling a frame from a sync initiation: an initiation is one unbroken
+// carrier of INITIATION_PULSE_MIN_US..INITIATION_PULSE_MAX_US (15-20 ms),
+// while nothing in a frame stays HIGH longer than 2 ms. A listening peer still
+// gets its RX interrupt on the first edge of a frame and enters
+// Request_WaitForInitialPulse, but the first HIGH pulse it measures is at most
+// 2 ms long, so it rejects the pulse and returns to Idle. Inside a frame each
+// attempt costs it one data pulse, because the line keeps producing HIGH pulses.
+// Only an interrupt on the frame's final edge leaves the peer waiting out
+// HANDSHAKE_TIMEOUT_US (500 ms) in pulseIn() before it is back in Idle.
+const int TX_PIN = 5; // GPIO for the transmitter data line.
+const int RX_PIN = 4; // GPIO for the receiver data line.
+
+const unsigned long TX_HALF_BIT_US = TX_BIT_US / 2;
+
+// Header bits of the first frame byte.
+const uint8_t TX_FLAG_FIRST = 0x80;
+const uint8_t TX_FLAG_LAST = 0x40;
+const uint8_t TX_PRIORITY_SHIFT = 4;
+
+// Worst-case time of one handle() call: a full frame plus scheduling slack.
+const uint32_t TX_FRAME_BUDGET_US = txFrameAirtimeUs(TX_FRAME_PAYLOAD) + 2000;
+
+// Forward declaration of the ISR function from the main .ino file
+// This is needed to re-attach the interrupt after the frame.
+void IRAM_ATTR handleRadioPulse();
+
+// Keys one byte onto the channel in Manchester code, MSB first. Blocking, like the sync preamble.
+static void sendByte(uint8_t value) {
+    for (int bit = 7; bit >= 0; --bit) {
+        bool one = (value >> bit) & 1;
+        digitalWrite(TX_PIN, one ? LOW : HIGH);
+        delayMicroseconds(TX_HALF_BIT_US);
+        digitalWrite(TX_PIN, one ? HIGH : LOW);
+        delayMicroseconds(TX_HALF_BIT_US);
+    }
+}
+
+// This is an explicit instantiation of the template.
+template class TxState<MasterStates>;
+
+template<typename StateIdType>
+void TxState<StateIdType>::handle() {
+    // One frame per call: the scheduler re-picks the class in between,
+    // which is what lets an alarm preempt a bulk upload.
+    TxFrame frame;
+    if (!txScheduler.nextFrame(micros(), frame)) {
+        this->machine_->setState(StateIdType::Idle);
+        return;
+    }
+
+    // The channel is half-duplex: our own carrier must not look like an incoming sync.
+    detachInterrupt(digitalPinToInterrupt(RX_PIN));
+
+    digitalWrite(TX_PIN, HIGH);
+    delayMicroseconds(TX_START_MARKER_US);
+    digitalWrite(TX_PIN, LOW);
+    delayMicroseconds(TX_BIT_US);
+
+    uint8_t flags = static_cast<uint8_t>(frame.priority) << TX_PRIORITY_SHIFT;
+    if (frame.first) flags |= TX_FLAG_FIRST;
+    if (frame.last) flags |= TX_FLAG_LAST;
+    sendByte(flags);
+    sendByte(frame.length);
+    for (uint8_t i = 0; i < frame.length; ++i) {
+        sendByte(frame.data[i]);
+    }
+    digitalWrite(TX_PIN, LOW);
+
+    attachInterrupt(digitalPinToInterrupt(RX_PIN), handleRadioPulse, CHANGE);
+    txScheduler.frameSent(micros());
+}
+
+template<typename StateIdType>
+uint32_t TxState<StateIdType>::getBudgetUs() const {
+    return TX_FRAME_BUDGET_US;
+}
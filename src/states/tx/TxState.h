@@ -1,5 +1,5 @@
-#ifndef IDLESTATE_H
-#define IDLESTATE_H
+#ifndef TXSTATE_H
+#define TXSTATE_H
 
 #include "state/State.h"
 #include "states/StateIds.h"
@@ -16,7 +16,8 @@ public:
      * @brief The main execution handler for this state.
      *
      * This method is called repeatedly by the StateMachine's update() loop
-     * while SyncState is the current state.
+     * while TxState is the current state. Each call sends one frame picked by
+     * txScheduler and returns to Idle once the queues are empty.
      */
     void handle() override;
 
@@ -27,6 +28,11 @@ public:
     StateIdType getStateId() const override {
         return StateIdType::Tx;
     }
+
+    /**
+     * @brief Budget for one handle() call: the on-air time of a full frame.
+     */
+    uint32_t getBudgetUs() const override;
 };
 
-#endif // IDLESTATE_H
+#endif // TXSTATE_H
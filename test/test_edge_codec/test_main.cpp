@@ -0,0 +1,166 @@
+// FILE: test/test_edge_codec/test_main.cpp
+// Native tests for the capture format and the pulseIn() replay (src/capture/EdgeCodec.h).
+
+#include <unity.h>
+#include "capture/EdgeCodec.h"
+
+static uint8_t buffer[512];
+
+void setUp() {}
+void tearDown() {}
+
+// Encodes a timeline that alternates levels, starting LOW.
+static size_t encodeTimeline(const uint32_t* durations, size_t count) {
+    EdgeEncoder encoder(buffer, sizeof(buffer));
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_TRUE(encoder.push(i & 1, durations[i]));
+    }
+    return encoder.size();
+}
+
+void test_round_trip_including_extremes() {
+    const uint32_t durations[] = { 0, 0xFFFFFFFF, 17500, 500, 498, 0, 502, 0xFFFFFFFF, 1, 22500 };
+    const size_t count = sizeof(durations) / sizeof(durations[0]);
+    size_t size = encodeTimeline(durations, count);
+
+    EdgeDecoder decoder(buffer, size);
+    uint8_t level;
+    uint32_t duration;
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_TRUE(decoder.next(level, duration));
+        TEST_ASSERT_EQUAL_UINT8(i & 1, level);
+        TEST_ASSERT_EQUAL_UINT32(durations[i], duration);
+    }
+    TEST_ASSERT_FALSE(decoder.next(level, duration));
+    TEST_ASSERT_FALSE(decoder.malformed());
+}
+
+void test_preamble_compresses_to_one_byte_per_record() {
+    uint32_t durations[40];
+    for (size_t i = 0; i < 40; ++i) {
+        durations[i] = 500 + (i % 3); // Jittery 500 us preamble.
+    }
+    size_t size = encodeTimeline(durations, 40);
+    // The first record of each level carries the absolute width.
+    TEST_ASSERT_EQUAL(2 * 2 + 38, size);
+}
+
+void test_header_round_trip_and_rejection() {
+    uint8_t header[EDGE_CAPTURE_HEADER_SIZE];
+    uint32_t length = 0;
+    uint8_t flags = 0xFF;
+    writeEdgeCaptureHeader(header, 0x01020304);
+    TEST_ASSERT_TRUE(parseEdgeCaptureHeader(header, length, &flags));
+    TEST_ASSERT_EQUAL_UINT32(0x01020304, length);
+    TEST_ASSERT_EQUAL_UINT8(0, flags);
+
+    writeEdgeCaptureHeader(header, 7, EDGE_CAPTURE_FLAG_EDGES_DROPPED);
+    TEST_ASSERT_TRUE(parseEdgeCaptureHeader(header, length, &flags));
+    TEST_ASSERT_EQUAL_UINT32(7, length);
+    TEST_ASSERT_EQUAL_UINT8(EDGE_CAPTURE_FLAG_EDGES_DROPPED, flags);
+
+    header[4] = EDGE_CAPTURE_VERSION + 1;
+    TEST_ASSERT_FALSE(parseEdgeCaptureHeader(header, length));
+    header[4] = EDGE_CAPTURE_VERSION;
+    header[0] = 'X';
+    TEST_ASSERT_FALSE(parseEdgeCaptureHeader(header, length));
+}
+
+void test_encoder_overflow_keeps_clean_prefix() {
+    EdgeEncoder encoder(buffer, 4);
+    TEST_ASSERT_TRUE(encoder.push(1, 100));  // 2 bytes
+    TEST_ASSERT_FALSE(encoder.push(0, 100000)); // 3 bytes, does not fit
+    TEST_ASSERT_TRUE(encoder.overflowed());
+    TEST_ASSERT_FALSE(encoder.push(1, 100)); // Would fit, but the prefix must stay contiguous.
+    TEST_ASSERT_EQUAL(1, encoder.records());
+}
+
+void test_truncated_varint_is_malformed() {
+    const uint8_t payload[] = { 0x80, 0x80 };
+    EdgeDecoder decoder(payload, sizeof(payload));
+    uint8_t level;
+    uint32_t duration;
+    TEST_ASSERT_FALSE(decoder.next(level, duration));
+    TEST_ASSERT_TRUE(decoder.malformed());
+}
+
+void test_replay_follows_pulsein_semantics() {
+    // LOW 1000, HIGH 17500, LOW 500, HIGH 500, LOW 500, HIGH 500, LOW 2000
+    const uint32_t durations[] = { 1000, 17500, 500, 500, 500, 500, 2000 };
+    size_t size = encodeTimeline(durations, 7);
+    EdgeReplayer line(buffer, size);
+
+    TEST_ASSERT_EQUAL_UINT32(17500, line.pulseIn(1, 500000));
+    // The line is LOW right after a HIGH pulse; like pulseIn(), that ongoing
+    // LOW is skipped and the next complete one is measured.
+    TEST_ASSERT_EQUAL_UINT32(500, line.pulseIn(0, 500000));
+    // Same for the HIGH now in progress; the trailing LOW never ends: timeout.
+    TEST_ASSERT_EQUAL_UINT32(0, line.pulseIn(1, 500000));
+    TEST_ASSERT_TRUE(line.ended());
+}
+
+void test_replay_skips_an_ongoing_pulse() {
+    // The line is already HIGH when the decoder starts reading, as after a late wake.
+    const uint32_t durations[] = { 0, 3000, 500, 700, 500 };
+    size_t size = encodeTimeline(durations, 5);
+    EdgeReplayer line(buffer, size);
+    TEST_ASSERT_EQUAL_UINT32(700, line.pulseIn(1, 500000));
+}
+
+void test_replay_timeout_stops_the_virtual_clock() {
+    // LOW 40000, HIGH 600, LOW 100
+    const uint32_t durations[] = { 40000, 600, 100 };
+    size_t size = encodeTimeline(durations, 3);
+    EdgeReplayer line(buffer, size);
+
+    TEST_ASSERT_EQUAL_UINT32(0, line.pulseIn(1, 30000)); // 30 ms into the LOW
+    TEST_ASSERT_EQUAL_UINT32(600, line.pulseIn(1, 30000)); // 10 ms of LOW left, then the pulse
+
+    line.rewind();
+    TEST_ASSERT_EQUAL_UINT32(600, line.pulseIn(1, 50000));
+    TEST_ASSERT_EQUAL_UINT32(3, line.getEdges());
+}
+
+void test_replay_times_ongoing_wake_pulse() {
+    // A wake capture starts inside the pulse, backdated to its rising edge.
+    EdgeEncoder encoder(buffer, sizeof(buffer));
+    encoder.push(1, 17000);
+    encoder.push(0, 500);
+    encoder.push(1, 25000);
+    encoder.push(0, 500);
+    EdgeReplayer line(buffer, encoder.size());
+
+    TEST_ASSERT_EQUAL_UINT32(17000, line.ongoingPulse(1, 20000));
+    TEST_ASSERT_EQUAL_UINT32(0, line.ongoingPulse(1, 20000)); // Line is LOW now.
+    TEST_ASSERT_EQUAL_UINT32(500, line.ongoingPulse(0, 20000));
+    // Too long: stops just past the limit, like the live busy-wait.
+    TEST_ASSERT_EQUAL_UINT32(20001, line.ongoingPulse(1, 20000));
+    // pulseIn() skips the rest of that pulse.
+    TEST_ASSERT_EQUAL_UINT32(0, line.pulseIn(1, 100000));
+}
+
+void test_replay_merges_repeated_levels() {
+    // A missed edge leaves two HIGH segments in a row; they form one pulse.
+    EdgeEncoder encoder(buffer, sizeof(buffer));
+    encoder.push(0, 100);
+    encoder.push(1, 300);
+    encoder.push(1, 200);
+    encoder.push(0, 100);
+    EdgeReplayer line(buffer, encoder.size());
+    TEST_ASSERT_EQUAL_UINT32(500, line.pulseIn(1, 10000));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_including_extremes);
+    RUN_TEST(test_preamble_compresses_to_one_byte_per_record);
+    RUN_TEST(test_header_round_trip_and_rejection);
+    RUN_TEST(test_encoder_overflow_keeps_clean_prefix);
+    RUN_TEST(test_truncated_varint_is_malformed);
+    RUN_TEST(test_replay_follows_pulsein_semantics);
+    RUN_TEST(test_replay_skips_an_ongoing_pulse);
+    RUN_TEST(test_replay_timeout_stops_the_virtual_clock);
+    RUN_TEST(test_replay_times_ongoing_wake_pulse);
+    RUN_TEST(test_replay_merges_repeated_levels);
+    return UNITY_END();
+}
@@ -0,0 +1,64 @@
+// FILE: test/test_power/FakeSleepHal.h
+
+#ifndef FAKESLEEPHAL_H
+#define FAKESLEEPHAL_H
+
+#include "power/SleepHal.h"
+
+/**
+ * @brief SleepHal with a scripted clock and pin levels.
+ * Light sleep jumps the clock straight to the first wake event. Every nowUs()
+ * read costs 1 us, so busy-waits on the clock terminate.
+ */
+class FakeSleepHal : public SleepHal {
+public:
+    static const unsigned long NEVER = ~0UL;
+
+    unsigned long clockUs = 0;
+    unsigned long flushUs = 0;        // Spent in lightSleep() before the CPU actually sleeps.
+    long timerLatencyUs = 0;          // How late a timer wake fires; negative fires early.
+    unsigned long gpioLatencyUs = 0;  // From a wake edge to code running again.
+
+    // Scripted radio pulse, HIGH in [radioRiseUs, radioFallUs).
+    unsigned long radioRiseUs = NEVER;
+    unsigned long radioFallUs = NEVER;
+    // Scripted button press, LOW from buttonPressUs on.
+    unsigned long buttonPressUs = NEVER;
+
+    int sleeps = 0;
+    int armedPins = 0;
+    unsigned long lastTimerUs = 0;
+
+    void armPinWake(WakePin) override { armedPins++; }
+    void disarmPinWake(WakePin) override { armedPins--; }
+
+    SleepResult lightSleep(unsigned long timerUs) override {
+        sleeps++;
+        lastTimerUs = timerUs;
+        clockUs += flushUs;
+        SleepResult result;
+        result.entryUs = clockUs;
+
+        unsigned long deadlineUs = clockUs + timerUs;
+        unsigned long edgeUs = radioRiseUs < buttonPressUs ? radioRiseUs : buttonPressUs;
+        if (edgeUs >= clockUs && edgeUs < deadlineUs) {
+            clockUs = edgeUs + gpioLatencyUs;
+            result.cause = SleepWakeCause::Gpio;
+        } else {
+            clockUs = deadlineUs + static_cast<unsigned long>(timerLatencyUs);
+            result.cause = SleepWakeCause::Timer;
+        }
+        return result;
+    }
+
+    unsigned long nowUs() override { return clockUs++; }
+
+    bool isPinActive(WakePin pin) override {
+        if (pin == WakePin::Radio) {
+            return clockUs >= radioRiseUs && clockUs < radioFallUs;
+        }
+        return clockUs >= buttonPressUs;
+    }
+};
+
+#endif // FAKESLEEPHAL_H
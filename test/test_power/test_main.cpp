@@ -0,0 +1,187 @@
+// FILE: test/test_power/test_main.cpp
+// Native tests for the wake latency logic of PowerManager (src/power/PowerManager.h).
+
+#include <unity.h>
+#include "power/PowerManager.h"
+#include "FakeSleepHal.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_disabled_never_sleeps() {
+    FakeSleepHal hal;
+    PowerManager pm(hal);
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::None);
+    TEST_ASSERT_EQUAL(0, hal.sleeps);
+}
+
+void test_timer_wake_calibrates_latency_from_sleep_entry() {
+    FakeSleepHal hal;
+    hal.flushUs = 5000; // A long log line still draining must not count as latency.
+    hal.timerLatencyUs = 200;
+    PowerManager pm(hal);
+    pm.begin();
+
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::None); // Plain calibration wake.
+    TEST_ASSERT_EQUAL_UINT32(PowerManager::MAX_SLEEP_US, hal.lastTimerUs);
+    // One sample folded into the default at 1/8 weight: (7 * 1000 + 200) / 8.
+    TEST_ASSERT_UINT32_WITHIN(2, 900, pm.getWakeLatencyUs());
+
+    for (int i = 0; i < 60; ++i) {
+        pm.sleep();
+    }
+    TEST_ASSERT_UINT32_WITHIN(10, 200, pm.getWakeLatencyUs());
+    TEST_ASSERT_EQUAL(0, hal.armedPins); // Every armed pin was restored.
+}
+
+void test_early_timer_wake_does_not_poison_latency() {
+    FakeSleepHal hal;
+    hal.timerLatencyUs = -20; // The sleep timer fires before its nominal deadline.
+    PowerManager pm(hal);
+    pm.begin();
+
+    for (int i = 0; i < 80; ++i) {
+        TEST_ASSERT_TRUE(pm.sleep() == WakeSource::None);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10, pm.getWakeLatencyUs());
+
+    // Scheduled wakes still sleep instead of hitting the not-worth-sleeping branch.
+    pm.scheduleWake(50000);
+    int sleeps = hal.sleeps;
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Timer);
+    TEST_ASSERT_EQUAL(sleeps + 1, hal.sleeps);
+
+    // And a radio wake still measures a sane pulse.
+    hal.radioRiseUs = hal.clockUs + 1000;
+    hal.radioFallUs = hal.radioRiseUs + 17500;
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Radio);
+    unsigned long durationUs = 0;
+    TEST_ASSERT_TRUE(pm.measureWakePulse(20000, durationUs));
+    TEST_ASSERT_UINT32_WITHIN(20, 17500, durationUs);
+}
+
+void test_scheduled_wake_fires_early_by_latency() {
+    FakeSleepHal hal;
+    hal.timerLatencyUs = PowerManager::DEFAULT_WAKE_LATENCY_US;
+    PowerManager pm(hal);
+    pm.begin();
+
+    pm.scheduleWake(50000);
+    unsigned long dueUs = hal.clockUs + 50000;
+    pm.scheduleWake(80000); // Later request loses.
+
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Timer);
+    TEST_ASSERT_UINT32_WITHIN(5, 50000 - PowerManager::DEFAULT_WAKE_LATENCY_US, hal.lastTimerUs);
+    // Woke on time because the timer was armed early by the expected latency.
+    TEST_ASSERT_UINT32_WITHIN(5, dueUs, hal.clockUs);
+
+    TEST_ASSERT_TRUE(pm.consumeTimerWake());
+    TEST_ASSERT_FALSE(pm.consumeTimerWake());
+    // Nothing left scheduled: the next sleep is a calibration wake.
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::None);
+}
+
+void test_not_worth_sleeping_when_wake_is_near() {
+    FakeSleepHal hal;
+    PowerManager pm(hal);
+    pm.begin();
+
+    pm.scheduleWake(PowerManager::DEFAULT_WAKE_LATENCY_US / 2);
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Timer);
+    TEST_ASSERT_EQUAL(0, hal.sleeps);
+    TEST_ASSERT_TRUE(pm.consumeTimerWake());
+    TEST_ASSERT_FALSE(pm.consumeTimerWake());
+}
+
+void test_consume_timer_wake_without_low_power_idle() {
+    FakeSleepHal hal;
+    PowerManager pm(hal); // Not begun: sleep() never runs.
+
+    pm.scheduleWake(100);
+    TEST_ASSERT_FALSE(pm.consumeTimerWake());
+    hal.clockUs += 200;
+    TEST_ASSERT_TRUE(pm.consumeTimerWake());
+    TEST_ASSERT_FALSE(pm.consumeTimerWake());
+}
+
+void test_radio_wake_measures_pulse_from_estimated_edge() {
+    FakeSleepHal hal;
+    hal.gpioLatencyUs = PowerManager::DEFAULT_WAKE_LATENCY_US;
+    hal.radioRiseUs = 300000;
+    hal.radioFallUs = 317500;
+    PowerManager pm(hal);
+    pm.begin();
+
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Radio);
+    unsigned long edgeUs = 0;
+    TEST_ASSERT_TRUE(pm.getRadioWakeEdge(edgeUs));
+    TEST_ASSERT_UINT32_WITHIN(5, 300000, edgeUs);
+    unsigned long durationUs = 0;
+    TEST_ASSERT_TRUE(pm.measureWakePulse(20000, durationUs));
+    TEST_ASSERT_UINT32_WITHIN(5, 17500, durationUs);
+    TEST_ASSERT_FALSE(pm.getRadioWakeEdge(edgeUs)); // Consumed with the wake.
+    TEST_ASSERT_UINT32_WITHIN(5, PowerManager::DEFAULT_WAKE_LATENCY_US, pm.getLastWakeToHandleUs());
+
+    // Only valid once per wake.
+    TEST_ASSERT_FALSE(pm.measureWakePulse(20000, durationUs));
+}
+
+void test_radio_wake_pulse_capped_at_max() {
+    FakeSleepHal hal;
+    hal.gpioLatencyUs = PowerManager::DEFAULT_WAKE_LATENCY_US;
+    hal.radioRiseUs = 1000; // Carrier that never drops.
+    PowerManager pm(hal);
+    pm.begin();
+
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Radio);
+    unsigned long durationUs = 0;
+    TEST_ASSERT_TRUE(pm.measureWakePulse(20000, durationUs));
+    TEST_ASSERT_UINT32_WITHIN(5, 20000, durationUs);
+}
+
+void test_radio_wake_pulse_already_over() {
+    FakeSleepHal hal;
+    hal.gpioLatencyUs = 100;
+    hal.radioRiseUs = 1000;
+    hal.radioFallUs = 1500;
+    PowerManager pm(hal);
+    pm.begin();
+
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Radio);
+    hal.clockUs = 2000; // The sync state got to run too late.
+    unsigned long durationUs = 0;
+    TEST_ASSERT_FALSE(pm.measureWakePulse(20000, durationUs));
+}
+
+void test_button_and_glitch_wakes() {
+    FakeSleepHal hal;
+    hal.buttonPressUs = 5000;
+    PowerManager pm(hal);
+    pm.begin();
+    TEST_ASSERT_TRUE(pm.sleep() == WakeSource::Button);
+
+    FakeSleepHal glitchHal;
+    glitchHal.gpioLatencyUs = 100;
+    glitchHal.radioRiseUs = 5000;
+    glitchHal.radioFallUs = 5050; // Gone before the wake could read it.
+    PowerManager glitchPm(glitchHal);
+    glitchPm.begin();
+    TEST_ASSERT_TRUE(glitchPm.sleep() == WakeSource::None);
+    unsigned long durationUs = 0;
+    TEST_ASSERT_FALSE(glitchPm.measureWakePulse(20000, durationUs));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_never_sleeps);
+    RUN_TEST(test_timer_wake_calibrates_latency_from_sleep_entry);
+    RUN_TEST(test_early_timer_wake_does_not_poison_latency);
+    RUN_TEST(test_scheduled_wake_fires_early_by_latency);
+    RUN_TEST(test_not_worth_sleeping_when_wake_is_near);
+    RUN_TEST(test_consume_timer_wake_without_low_power_idle);
+    RUN_TEST(test_radio_wake_measures_pulse_from_estimated_edge);
+    RUN_TEST(test_radio_wake_pulse_capped_at_max);
+    RUN_TEST(test_radio_wake_pulse_already_over);
+    RUN_TEST(test_button_and_glitch_wakes);
+    return UNITY_END();
+}
@@ -0,0 +1,126 @@
+// FILE: test/test_state_profiler/test_main.cpp
+// Native tests for the deadline monitor and WCET histograms (src/state/StateProfiler.h).
+
+#include <unity.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+#include "state/StateProfiler.h"
+
+enum class TestStates { Fast, Slow, Unbudgeted, NeverRun };
+
+// Collects dump() output the way Serial would print it.
+struct StringOutput {
+    std::string text;
+    void printf(const char* format, ...) {
+        char line[128];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        text += line;
+    }
+    void println() { text += "\n"; }
+};
+
+static int overrunCalls = 0;
+static TestStates overrunId;
+static uint32_t overrunElapsedUs = 0;
+static uint32_t overrunBudgetUs = 0;
+
+static void onOverrun(TestStates id, uint32_t elapsedUs, uint32_t budgetUs) {
+    overrunCalls++;
+    overrunId = id;
+    overrunElapsedUs = elapsedUs;
+    overrunBudgetUs = budgetUs;
+}
+
+void setUp() {
+    overrunCalls = 0;
+}
+void tearDown() {}
+
+void test_buckets_follow_log2() {
+    StateProfiler<TestStates> profiler;
+    StateTimingStats* stats = profiler.addState(TestStates::Fast, 0);
+
+    const uint32_t samples[] = { 0, 1, 2, 3, 4, 1000, 1023, 1024, 0xFFFFFFFF };
+    for (uint32_t us : samples) {
+        profiler.record(TestStates::Fast, *stats, us);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, stats->buckets[0]);  // 0 and 1
+    TEST_ASSERT_EQUAL_UINT32(2, stats->buckets[1]);  // 2 and 3
+    TEST_ASSERT_EQUAL_UINT32(1, stats->buckets[2]);  // 4
+    TEST_ASSERT_EQUAL_UINT32(2, stats->buckets[9]);  // 1000 and 1023
+    TEST_ASSERT_EQUAL_UINT32(1, stats->buckets[10]); // 1024
+    TEST_ASSERT_EQUAL_UINT32(1, stats->buckets[StateTimingStats::BUCKET_COUNT - 1]); // Open-ended top.
+    TEST_ASSERT_EQUAL_UINT32(9, stats->calls);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, stats->maxUs);
+}
+
+void test_overruns_need_a_budget() {
+    StateProfiler<TestStates> profiler;
+    profiler.setOverrunCallback(onOverrun);
+    StateTimingStats* slow = profiler.addState(TestStates::Slow, 500);
+    StateTimingStats* unbudgeted = profiler.addState(TestStates::Unbudgeted, 0);
+
+    profiler.record(TestStates::Slow, *slow, 500); // At the budget is not an overrun.
+    TEST_ASSERT_EQUAL(0, overrunCalls);
+    profiler.record(TestStates::Slow, *slow, 501);
+    TEST_ASSERT_EQUAL(1, overrunCalls);
+    TEST_ASSERT_TRUE(overrunId == TestStates::Slow);
+    TEST_ASSERT_EQUAL_UINT32(501, overrunElapsedUs);
+    TEST_ASSERT_EQUAL_UINT32(500, overrunBudgetUs);
+
+    profiler.record(TestStates::Unbudgeted, *unbudgeted, 1000000);
+    TEST_ASSERT_EQUAL(1, overrunCalls);
+    TEST_ASSERT_EQUAL_UINT32(1, slow->overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, unbudgeted->overruns);
+    TEST_ASSERT_EQUAL_UINT32(1, profiler.getTotalOverruns());
+}
+
+void test_overruns_counted_without_callback() {
+    StateProfiler<TestStates> profiler;
+    StateTimingStats* slow = profiler.addState(TestStates::Slow, 10);
+    profiler.record(TestStates::Slow, *slow, 11);
+    TEST_ASSERT_EQUAL_UINT32(1, profiler.getTotalOverruns());
+}
+
+void test_reset_keeps_budgets() {
+    StateProfiler<TestStates> profiler;
+    StateTimingStats* slow = profiler.addState(TestStates::Slow, 500);
+    profiler.record(TestStates::Slow, *slow, 900);
+
+    profiler.reset();
+    const StateTimingStats* stats = profiler.getStats(TestStates::Slow);
+    TEST_ASSERT_TRUE(stats == slow); // Slots stay where the machine cached them.
+    TEST_ASSERT_EQUAL_UINT32(500, stats->budgetUs);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->calls);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->maxUs);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->buckets[9]);
+    TEST_ASSERT_EQUAL_UINT32(0, profiler.getTotalOverruns());
+    TEST_ASSERT_TRUE(profiler.find(TestStates::NeverRun) == nullptr);
+}
+
+void test_dump_lists_states_that_ran() {
+    StateProfiler<TestStates> profiler;
+    StateTimingStats* slow = profiler.addState(TestStates::Slow, 500);
+    profiler.addState(TestStates::NeverRun, 100);
+    profiler.record(TestStates::Slow, *slow, 3);
+    profiler.record(TestStates::Slow, *slow, 600);
+
+    StringOutput out;
+    profiler.dump(out);
+    TEST_ASSERT_EQUAL_STRING("1 n=2 max=600 budget=500 over=1 h=1:1,9:1\n", out.text.c_str());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_buckets_follow_log2);
+    RUN_TEST(test_overruns_need_a_budget);
+    RUN_TEST(test_overruns_counted_without_callback);
+    RUN_TEST(test_reset_keeps_budgets);
+    RUN_TEST(test_dump_lists_states_that_ran);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+// FILE: test/test_sync_replay/test_main.cpp
+// Replays a corpus of captures through the receiver's decode sub-states
+// (src/states/sync/SyncReplay.h).
+//
+// The built-in corpus is synthesized with EdgeEncoder. Recorded captures can be
+// added without rebuilding: dump them with tools/edgecap.py, rename each one to
+// state the expected result (capture_003.synced-500.edgc, capture_004.rejected.edgc,
+// capture_005.timeout.edgc) and point SYNC_REPLAY_CORPUS at their directory.
+
+#include <unity.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "capture/EdgeCodec.h"
+#include "states/sync/SyncReplay.h"
+
+static uint8_t file[4096];
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * Builds a capture file from a timeline of alternating levels.
+ * @param firstLevel Level of durations[0].
+ * @return Size of the whole file, header included.
+ */
+static size_t buildCapture(uint8_t firstLevel, const uint32_t* durations, size_t count, uint8_t flags = 0) {
+    EdgeEncoder encoder(file + EDGE_CAPTURE_HEADER_SIZE, sizeof(file) - EDGE_CAPTURE_HEADER_SIZE);
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_TRUE(encoder.push((firstLevel + i) & 1, durations[i]));
+    }
+    writeEdgeCaptureHeader(file, encoder.size(), flags);
+    return EDGE_CAPTURE_HEADER_SIZE + encoder.size();
+}
+
+/**
+ * An initiator's transmission as the receiver's line sees it: an initiation
+ * pulse, a gap, `pulses` preamble periods of width us HIGH and LOW, and a
+ * quiet tail. Each preamble edge is moved by up to +-jitterUs.
+ * @return Number of durations written, starting with HIGH.
+ */
+static size_t initiatorTimeline(uint32_t* durations, uint32_t initiationUs, uint32_t width,
+                                unsigned int pulses, uint32_t jitterUs = 0) {
+    size_t n = 0;
+    durations[n++] = initiationUs;
+    durations[n++] = 1000;
+    for (unsigned int i = 0; i < pulses; ++i) {
+        uint32_t jitter = jitterUs ? (i * 7) % (2 * jitterUs + 1) : 0; // Deterministic spread.
+        durations[n++] = width + jitter - jitterUs;
+        durations[n++] = width - jitter + jitterUs;
+    }
+    durations[n - 1] += 30000; // The last LOW runs into the silence after the preamble.
+    return n;
+}
+
+static SyncReplayResult replay(size_t size) {
+    SyncReplayResult result;
+    TEST_ASSERT_TRUE(replaySyncCapture(file, size, result));
+    return result;
+}
+
+// ============================================================================
+// Built-in corpus
+// ============================================================================
+
+void test_clean_handshake_is_decoded() {
+    uint32_t durations[64];
+    durations[0] = 300; // Quiet line before the initiator keys up.
+    size_t n = 1 + initiatorTimeline(durations + 1, 17500, 500, 20);
+    SyncReplayResult result = replay(buildCapture(0, durations, n));
+
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Request_SendConfirmation);
+    TEST_ASSERT_EQUAL_UINT32(500, result.pulseWidthUs);
+    TEST_ASSERT_EQUAL_UINT8(0, result.flags);
+    TEST_ASSERT_FALSE(result.malformed);
+}
+
+void test_jittery_preamble_averages_out() {
+    uint32_t durations[64];
+    durations[0] = 300;
+    size_t n = 1 + initiatorTimeline(durations + 1, 16000, 250, 20, 5);
+    SyncReplayResult result = replay(buildCapture(0, durations, n));
+
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Request_SendConfirmation);
+    TEST_ASSERT_UINT32_WITHIN(2, 250, result.pulseWidthUs);
+}
+
+void test_wake_start_capture_times_the_wake_pulse() {
+    uint32_t durations[64];
+    size_t n = initiatorTimeline(durations, 17500, 500, 20);
+    SyncReplayResult result = replay(buildCapture(1, durations, n, EDGE_CAPTURE_FLAG_WAKE_START));
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Request_SendConfirmation);
+    TEST_ASSERT_EQUAL_UINT32(500, result.pulseWidthUs);
+
+    // Without the flag the wake pulse is already under way, so pulseIn() skips it
+    // and times the first preamble pulse instead, as it would have live.
+    result = replay(buildCapture(1, durations, n));
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Idle);
+}
+
+void test_noise_and_short_initiations_are_rejected() {
+    const uint32_t noise[] = { 100, 40, 2000, 900000 };
+    SyncReplayResult result = replay(buildCapture(0, noise, 4));
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Idle);
+    TEST_ASSERT_EQUAL_UINT32(0, result.pulseWidthUs);
+
+    uint32_t durations[64];
+    durations[0] = 300;
+    size_t n = 1 + initiatorTimeline(durations + 1, 12000, 500, 20);
+    result = replay(buildCapture(0, durations, n));
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Idle);
+
+    // A carrier stuck HIGH is no initiation either.
+    n = 1 + initiatorTimeline(durations + 1, 25000, 500, 20);
+    result = replay(buildCapture(0, durations, n));
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Idle);
+}
+
+void test_cut_preamble_times_out() {
+    uint32_t durations[64];
+    durations[0] = 300;
+    size_t n = 1 + initiatorTimeline(durations + 1, 17500, 500, 6);
+    SyncReplayResult result = replay(buildCapture(0, durations, n, EDGE_CAPTURE_FLAG_TRUNCATED));
+
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Timeout);
+    TEST_ASSERT_EQUAL_UINT32(0, result.pulseWidthUs);
+    TEST_ASSERT_EQUAL_UINT8(EDGE_CAPTURE_FLAG_TRUNCATED, result.flags);
+}
+
+void test_damaged_files() {
+    uint32_t durations[64];
+    durations[0] = 300;
+    size_t n = 1 + initiatorTimeline(durations + 1, 17500, 500, 20);
+    size_t size = buildCapture(0, durations, n);
+    SyncReplayResult result;
+
+    TEST_ASSERT_FALSE(replaySyncCapture(file, EDGE_CAPTURE_HEADER_SIZE - 1, result));
+    TEST_ASSERT_FALSE(replaySyncCapture(file, size - 1, result)); // Header promises more.
+
+    // A record cut inside its varint decodes as far as it goes.
+    n = 1 + initiatorTimeline(durations + 1, 17500, 500, 4);
+    size = buildCapture(0, durations, n);
+    file[size++] = 0x80;
+    writeEdgeCaptureHeader(file, size - EDGE_CAPTURE_HEADER_SIZE);
+    result = replay(size);
+    TEST_ASSERT_TRUE(result.outcome == SyncStates::Timeout);
+    TEST_ASSERT_TRUE(result.malformed);
+
+    file[0] = 'X';
+    TEST_ASSERT_FALSE(replaySyncCapture(file, size, result));
+}
+
+void test_replay_throughput() {
+    uint32_t durations[64];
+    durations[0] = 300;
+    size_t n = 1 + initiatorTimeline(durations + 1, 17500, 500, 20, 3);
+    size_t size = buildCapture(0, durations, n);
+
+    const int ROUNDS = 20000;
+    uint64_t edges = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        SyncReplayResult result = replay(size);
+        edges += result.edges;
+    }
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    char line[120];
+    snprintf(line, sizeof(line), "replayed %d captures, %llu edges in %lld us (%llu edges/s)",
+             ROUNDS, (unsigned long long)edges, (long long)elapsedUs,
+             (unsigned long long)(elapsedUs > 0 ? edges * 1000000ULL / elapsedUs : 0));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(edges > 0);
+}
+
+// ============================================================================
+// Recorded corpus
+// ============================================================================
+
+/**
+ * Replays every *.edgc in $SYNC_REPLAY_CORPUS. The expected result is taken
+ * from the file name: ".synced-<width>." (pulse width within 2 %),
+ * ".rejected." or ".timeout.". Files without one are only checked to parse.
+ */
+void test_recorded_corpus() {
+    const char* dirName = getenv("SYNC_REPLAY_CORPUS");
+    if (dirName == nullptr) {
+        TEST_IGNORE_MESSAGE("SYNC_REPLAY_CORPUS not set");
+    }
+    DIR* dir = opendir(dirName);
+    TEST_ASSERT_NOT_NULL_MESSAGE(dir, dirName);
+
+    static uint8_t recorded[64 * 1024];
+    char path[512];
+    unsigned int replayed = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        size_t length = strlen(name);
+        if (length < 5 || strcmp(name + length - 5, ".edgc") != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dirName, name);
+        FILE* f = fopen(path, "rb");
+        TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+        size_t size = fread(recorded, 1, sizeof(recorded), f);
+        fclose(f);
+
+        SyncReplayResult result;
+        TEST_ASSERT_TRUE_MESSAGE(replaySyncCapture(recorded, size, result), name);
+        if (const char* synced = strstr(name, ".synced-")) {
+            unsigned long width = strtoul(synced + 8, nullptr, 10);
+            TEST_ASSERT_TRUE_MESSAGE(result.outcome == SyncStates::Request_SendConfirmation, name);
+            TEST_ASSERT_UINT32_WITHIN_MESSAGE(width / 50 + 1, width, result.pulseWidthUs, name);
+        } else if (strstr(name, ".rejected.")) {
+            TEST_ASSERT_TRUE_MESSAGE(result.outcome == SyncStates::Idle, name);
+        } else if (strstr(name, ".timeout.")) {
+            TEST_ASSERT_TRUE_MESSAGE(result.outcome == SyncStates::Timeout, name);
+        }
+        replayed++;
+    }
+    closedir(dir);
+
+    char line[80];
+    snprintf(line, sizeof(line), "replayed %u recorded captures", replayed);
+    TEST_MESSAGE(line);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_clean_handshake_is_decoded);
+    RUN_TEST(test_jittery_preamble_averages_out);
+    RUN_TEST(test_wake_start_capture_times_the_wake_pulse);
+    RUN_TEST(test_noise_and_short_initiations_are_rejected);
+    RUN_TEST(test_cut_preamble_times_out);
+    RUN_TEST(test_damaged_files);
+    RUN_TEST(test_replay_throughput);
+    RUN_TEST(test_recorded_corpus);
+    return UNITY_END();
+}
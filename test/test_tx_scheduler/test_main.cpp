@@ -0,0 +1,209 @@
+// FILE: test/test_tx_scheduler/test_main.cpp
+// Native tests and a channel simulation for the TX scheduler (src/states/tx/TxScheduler.h).
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "states/tx/TxScheduler.h"
+
+static uint8_t message[TX_MAX_MESSAGE_SIZE];
+
+void setUp() {
+    for (size_t i = 0; i < sizeof(message); ++i) {
+        message[i] = static_cast<uint8_t>(i);
+    }
+}
+void tearDown() {}
+
+void test_highest_class_goes_first() {
+    TxScheduler scheduler;
+    TxFrame frame;
+    TEST_ASSERT_FALSE(scheduler.nextFrame(0, frame));
+
+    scheduler.enqueue(TxPriority::Bulk, message, 4, 0);
+    scheduler.enqueue(TxPriority::Control, message, 4, 0);
+    scheduler.enqueue(TxPriority::Alarm, message, 4, 0);
+    TEST_ASSERT_TRUE(scheduler.hasPending());
+
+    const TxPriority expected[] = { TxPriority::Alarm, TxPriority::Control, TxPriority::Bulk };
+    for (TxPriority priority : expected) {
+        TEST_ASSERT_TRUE(scheduler.nextFrame(0, frame));
+        TEST_ASSERT_TRUE(frame.priority == priority);
+        TEST_ASSERT_TRUE(frame.first && frame.last);
+        scheduler.frameSent(0);
+    }
+    TEST_ASSERT_FALSE(scheduler.hasPending());
+}
+
+void test_alarm_preempts_bulk_at_frame_boundary() {
+    TxScheduler scheduler;
+    TxFrame frame;
+    scheduler.enqueue(TxPriority::Bulk, message, 40, 0); // Three frames: 16 + 16 + 8.
+
+    TEST_ASSERT_TRUE(scheduler.nextFrame(0, frame));
+    TEST_ASSERT_EQUAL(TX_FRAME_PAYLOAD, frame.length);
+    TEST_ASSERT_TRUE(frame.first && !frame.last);
+    scheduler.frameSent(100);
+
+    scheduler.enqueue(TxPriority::Alarm, message, 2, 100);
+    TEST_ASSERT_TRUE(scheduler.nextFrame(100, frame));
+    TEST_ASSERT_TRUE(frame.priority == TxPriority::Alarm);
+    scheduler.frameSent(200);
+
+    // The upload resumes where it left off.
+    TEST_ASSERT_TRUE(scheduler.nextFrame(200, frame));
+    TEST_ASSERT_TRUE(frame.priority == TxPriority::Bulk);
+    TEST_ASSERT_FALSE(frame.first);
+    TEST_ASSERT_EQUAL_UINT8(TX_FRAME_PAYLOAD, frame.data[0]);
+    scheduler.frameSent(300);
+    TEST_ASSERT_TRUE(scheduler.nextFrame(300, frame));
+    TEST_ASSERT_EQUAL(8, frame.length);
+    TEST_ASSERT_TRUE(frame.last);
+    scheduler.frameSent(400);
+
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStats(TxPriority::Bulk).sent);
+    TEST_ASSERT_EQUAL_UINT32(400, scheduler.getStats(TxPriority::Bulk).maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(100, scheduler.getStats(TxPriority::Alarm).maxLatencyUs);
+}
+
+void test_stale_messages_are_dropped_unless_started() {
+    TxScheduler scheduler;
+    TxFrame frame;
+    scheduler.enqueue(TxPriority::Control, message, 4, 0, 1000);
+    TEST_ASSERT_FALSE(scheduler.nextFrame(2000, frame));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStats(TxPriority::Control).droppedStale);
+
+    // A message already partly on air is always finished.
+    scheduler.enqueue(TxPriority::Control, message, 20, 0, 1000);
+    TEST_ASSERT_TRUE(scheduler.nextFrame(500, frame));
+    scheduler.frameSent(600);
+    TEST_ASSERT_TRUE(scheduler.nextFrame(5000, frame));
+    TEST_ASSERT_TRUE(frame.last);
+    scheduler.frameSent(5100);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStats(TxPriority::Control).sent);
+
+    // Alarms have no maximum age by default.
+    scheduler.enqueue(TxPriority::Alarm, message, 1, 0);
+    TEST_ASSERT_TRUE(scheduler.nextFrame(100000000, frame));
+}
+
+void test_full_and_invalid_messages_are_rejected() {
+    TxScheduler scheduler;
+    for (size_t i = 0; i < TX_QUEUE_DEPTH; ++i) {
+        TEST_ASSERT_TRUE(scheduler.enqueue(TxPriority::Bulk, message, 1, 0));
+    }
+    TEST_ASSERT_FALSE(scheduler.enqueue(TxPriority::Bulk, message, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStats(TxPriority::Bulk).rejectedFull);
+    TEST_ASSERT_TRUE(scheduler.enqueue(TxPriority::Alarm, message, 1, 0)); // Other classes are unaffected.
+
+    TEST_ASSERT_FALSE(scheduler.enqueue(TxPriority::Control, message, 0, 0));
+    TEST_ASSERT_FALSE(scheduler.enqueue(TxPriority::Control, message, TX_MAX_MESSAGE_SIZE + 1, 0));
+}
+
+// ============================================================================
+// Channel simulation
+// ============================================================================
+
+// Deterministic xorshift32, so the benchmark numbers are reproducible.
+static uint32_t rngState = 0x2545F491;
+static uint32_t nextRandom(uint32_t bound) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % bound;
+}
+
+static int compareLatency(const void* a, const void* b) {
+    uint32_t x = *static_cast<const uint32_t*>(a);
+    uint32_t y = *static_cast<const uint32_t*>(b);
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Simulates one hour of channel time with TxState's one-frame-per-call loop.
+ * A bulk upload keeps the channel saturated, control messages arrive every
+ * second or so, and alarms arrive at random instants, i.e. usually in the
+ * middle of a bulk frame. Arrivals are enqueued at the next frame boundary
+ * but stamped with their real arrival time, as an application calling
+ * enqueue() from an ISR-fed loop would see them.
+ *
+ * An alarm can wait for at most one frame already on air (74.5 ms for a full
+ * one) and then needs its own airtime, so its latency must stay below
+ * txFrameAirtimeUs(TX_FRAME_PAYLOAD) + txFrameAirtimeUs(alarm length).
+ */
+void test_alarm_latency_under_saturating_bulk_load() {
+    const unsigned long SIM_US = 3600UL * 1000000UL;
+    const size_t MAX_ALARMS = 4096;
+    static uint32_t latencies[MAX_ALARMS];
+    static unsigned long arrivals[MAX_ALARMS];
+    static size_t lengths[MAX_ALARMS];
+    size_t alarmCount = 0;
+    size_t alarmsSent = 0;
+    uint32_t worstExcessUs = 0; // Latency beyond the per-alarm bound, must stay 0.
+
+    TxScheduler scheduler;
+    unsigned long nowUs = 0;
+    unsigned long nextAlarmUs = nextRandom(2000000);
+    unsigned long nextControlUs = nextRandom(1000000);
+
+    while (nowUs < SIM_US) {
+        // Deliver everything that arrived while the last frame was on air.
+        while (nextAlarmUs <= nowUs && alarmCount < MAX_ALARMS) {
+            lengths[alarmCount] = 1 + nextRandom(4);
+            arrivals[alarmCount] = nextAlarmUs;
+            TEST_ASSERT_TRUE(scheduler.enqueue(TxPriority::Alarm, message, lengths[alarmCount], nextAlarmUs));
+            alarmCount++;
+            nextAlarmUs += 200000 + nextRandom(2000000); // 0.2-2.2 s apart.
+        }
+        while (nextControlUs <= nowUs) {
+            scheduler.enqueue(TxPriority::Control, message, 8 + nextRandom(25), nextControlUs);
+            nextControlUs += 500000 + nextRandom(1000000);
+        }
+        while (scheduler.enqueue(TxPriority::Bulk, message, TX_MAX_MESSAGE_SIZE, nowUs)) {}
+
+        TxFrame frame;
+        TEST_ASSERT_TRUE(scheduler.nextFrame(nowUs, frame)); // Bulk never runs dry.
+        nowUs += txFrameAirtimeUs(frame.length);
+        scheduler.frameSent(nowUs);
+
+        if (frame.priority == TxPriority::Alarm && frame.last) {
+            uint32_t latencyUs = nowUs - arrivals[alarmsSent];
+            uint32_t boundUs = txFrameAirtimeUs(TX_FRAME_PAYLOAD) + txFrameAirtimeUs(lengths[alarmsSent]);
+            if (latencyUs > boundUs && latencyUs - boundUs > worstExcessUs) {
+                worstExcessUs = latencyUs - boundUs;
+            }
+            latencies[alarmsSent++] = latencyUs;
+        }
+    }
+
+    TEST_ASSERT_TRUE(alarmsSent > 1000);
+    qsort(latencies, alarmsSent, sizeof(latencies[0]), compareLatency);
+    const TxClassStats& alarm = scheduler.getStats(TxPriority::Alarm);
+    const TxClassStats& control = scheduler.getStats(TxPriority::Control);
+    const TxClassStats& bulk = scheduler.getStats(TxPriority::Bulk);
+
+    char line[160];
+    snprintf(line, sizeof(line), "alarms=%lu latency p50=%lu us p99=%lu us max=%lu us (min %lu us)",
+             (unsigned long)alarmsSent, (unsigned long)latencies[alarmsSent / 2],
+             (unsigned long)latencies[alarmsSent * 99 / 100], (unsigned long)latencies[alarmsSent - 1],
+             (unsigned long)latencies[0]);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "control sent=%lu stale=%lu max=%lu us, bulk sent=%lu max=%lu us",
+             (unsigned long)control.sent, (unsigned long)control.droppedStale, (unsigned long)control.maxLatencyUs,
+             (unsigned long)bulk.sent, (unsigned long)bulk.maxLatencyUs);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT32(0, worstExcessUs);
+    TEST_ASSERT_EQUAL_UINT32(latencies[alarmsSent - 1], alarm.maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(0, alarm.droppedStale);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_highest_class_goes_first);
+    RUN_TEST(test_alarm_preempts_bulk_at_frame_boundary);
+    RUN_TEST(test_stale_messages_are_dropped_unless_started);
+    RUN_TEST(test_full_and_invalid_messages_are_rejected);
+    RUN_TEST(test_alarm_latency_under_saturating_bulk_load);
+    return UNITY_END();
+}
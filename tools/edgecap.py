@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Host-side driver for RX edge captures (see src/capture/EdgeCodec.h).
+
+    edgecap.py dump   PORT OUTDIR   Read all captures stored in the 'edgecap' partition.
+    edgecap.py erase  PORT          Erase the stored captures.
+    edgecap.py replay PORT FILE...  Replay captures through the device's sync decoder.
+    edgecap.py decode FILE          Print a capture as a (level, duration) timeline.
+
+Needs pyserial for the PORT commands. The device must be in its Idle state.
+"""
+
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"EDGC"
+VERSION = 1
+HEADER_SIZE = 10
+BAUD = 115200
+
+# Header flag bits, see EDGE_CAPTURE_FLAG_* in EdgeCodec.h.
+FLAGS = {0x01: "truncated", 0x02: "edges dropped", 0x04: "wake start"}
+# Flags that mean the timeline differs from what the decoder saw live.
+LOSSY_FLAGS = 0x03
+
+
+def parse_header(data):
+    if len(data) < HEADER_SIZE or data[:4] != MAGIC or data[4] != VERSION:
+        raise ValueError("not an edge capture")
+    return struct.unpack_from("<I", data, 6)[0]
+
+
+def describe_flags(header, mask=0xFF):
+    """Names the flag bits of a capture header within mask, or '' if none are set."""
+    return ", ".join(name for bit, name in FLAGS.items() if header[5] & bit & mask)
+
+
+def split_captures(data):
+    """Splits back-to-back capture files into a list of complete files.
+
+    The device only sends whole captures, but anything that does not parse is
+    skipped up to the next magic rather than failing the whole dump.
+    """
+    captures = []
+    offset = 0
+    while offset + HEADER_SIZE <= len(data):
+        try:
+            length = parse_header(data[offset:offset + HEADER_SIZE])
+        except ValueError:
+            length = None
+        end = offset + HEADER_SIZE + (length or 0)
+        if length is None or end > len(data):
+            resync = data.find(MAGIC, offset + 1)
+            print("skipping %d unparsable bytes at offset %d" %
+                  ((resync if resync >= 0 else len(data)) - offset, offset), file=sys.stderr)
+            if resync < 0:
+                break
+            offset = resync
+            continue
+        captures.append(data[offset:end])
+        offset = end
+    return captures
+
+
+def decode(payload):
+    """Yields (level, duration_us) records, mirroring EdgeDecoder."""
+    previous = [0, 0]
+    value = shift = 0
+    for byte in payload:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80:
+            continue
+        level = value & 1
+        zigzag = value >> 1
+        delta = (zigzag >> 1) ^ -(zigzag & 1)
+        previous[level] = (previous[level] + delta) & 0xFFFFFFFF
+        yield level, previous[level]
+        value = shift = 0
+    if shift:
+        raise ValueError("truncated varint at end of payload")
+
+
+def open_port(port):
+    import serial  # pyserial
+    conn = serial.Serial(port, BAUD, timeout=2)
+    time.sleep(0.1)
+    conn.reset_input_buffer()
+    return conn
+
+
+def cmd_dump(port, outdir):
+    with open_port(port) as conn:
+        conn.write(b"dump\n")
+        while True:
+            line = conn.readline()
+            if not line:
+                sys.exit("no dump header received")
+            if line.startswith(b"EDGECAP DUMP"):
+                break
+        count, size = (int(x) for x in line.split()[2:4])
+        data = conn.read(size)
+    if len(data) != size:
+        sys.exit("dump truncated: %d of %d bytes" % (len(data), size))
+
+    os.makedirs(outdir, exist_ok=True)
+    captures = split_captures(data)
+    for i, capture in enumerate(captures):
+        with open(os.path.join(outdir, "capture_%03d.edgc" % i), "wb") as f:
+            f.write(capture)
+        if describe_flags(capture, LOSSY_FLAGS):
+            print("capture_%03d.edgc: %s" % (i, describe_flags(capture, LOSSY_FLAGS)))
+    print("%d captures (%d announced) written to %s" % (len(captures), count, outdir))
+
+
+def cmd_erase(port):
+    with open_port(port) as conn:
+        conn.write(b"erase\n")
+        print(conn.readline().decode(errors="replace").strip())
+
+
+def cmd_replay(port, files):
+    with open_port(port) as conn:
+        for name in files:
+            with open(name, "rb") as f:
+                capture = f.read()
+            parse_header(capture)
+            if describe_flags(capture, LOSSY_FLAGS):
+                print("%s: recorded with %s, may not replay as it ran live" %
+                      (name, describe_flags(capture, LOSSY_FLAGS)))
+            conn.write(capture)
+            # Echo the device log until the replay report line.
+            while True:
+                line = conn.readline().decode(errors="replace").rstrip()
+                if not line:
+                    print("%s: no replay report received" % name)
+                    break
+                if line.startswith("SyncState: Replayed") or line.startswith("EdgeCapture:"):
+                    print("%s: %s" % (name, line))
+                    if line.startswith("SyncState: Replayed"):
+                        break
+
+
+def cmd_decode(name):
+    with open(name, "rb") as f:
+        data = f.read()
+    length = parse_header(data)
+    if describe_flags(data):
+        print("# %s" % describe_flags(data))
+    t = 0
+    for level, duration in decode(data[HEADER_SIZE:HEADER_SIZE + length]):
+        print("%10d us  %s  %8d us" % (t, "HIGH" if level else "LOW ", duration))
+        t += duration
+
+
+def main(argv):
+    if len(argv) >= 4 and argv[1] == "dump":
+        cmd_dump(argv[2], argv[3])
+    elif len(argv) == 3 and argv[1] == "erase":
+        cmd_erase(argv[2])
+    elif len(argv) >= 4 and argv[1] == "replay":
+        cmd_replay(argv[2], argv[3:])
+    elif len(argv) == 3 and argv[1] == "decode":
+        cmd_decode(argv[2])
+    else:
+        sys.exit(__doc__)
+
+
+if __name__ == "__main__":
+    main(sys.argv)